@@ -6,11 +6,24 @@ layout (location = 2) in vec2 aTexCoords;
 out vec2 TexCoords;
 
 uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
+
+// compact vertices (PackedModel): unorm16 positions inside the model's bounds;
+// full-float vertices get scale 1 / offset 0
+uniform vec3 positionScale;
+uniform vec3 positionOffset;
+
+layout (std140) uniform FrameData
+{
+    mat4 view;
+    mat4 projection;
+    mat4 viewProj;
+    mat4 skyView;
+    vec4 cameraPos;
+};
 
 void main()
 {
+    vec3 position = aPos * positionScale + positionOffset;
     TexCoords = aTexCoords;    
-    gl_Position = projection * view * model * vec4(aPos, 1.0);
+    gl_Position = viewProj * model * vec4(position, 1.0);
 }
\ No newline at end of file
@@ -0,0 +1,278 @@
+#ifndef ASSET_LOADER_H
+#define ASSET_LOADER_H
+
+#include <glad/glad.h>
+#include <stb_image.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Background asset loading. A job has two halves:
+//   decode  runs on one of the loader's threads: file reads, parsing, image
+//           decoding, anything without GL calls
+//   upload  runs on the render thread from pump(), one step per call, until
+//           it returns true; big uploads split themselves into several steps
+// pump() is given a time budget per frame, so a slow upload costs a few
+// frames a little each instead of one long hitch. Until an asset is resident
+// the renderer keeps drawing whatever placeholder it started with.
+//
+// The loader has its own threads rather than using the frame's WorkerPool: a
+// multi-second parse would otherwise hold up every parallelFor behind it.
+class AssetLoader {
+public:
+    typedef std::function<bool()> Decode;     // false = failed, the upload is skipped
+    typedef std::function<bool()> UploadStep; // true = done
+
+    explicit AssetLoader(unsigned int threadCount = 2)
+    {
+        threadCount = std::max(1u, threadCount);
+        for (unsigned int i = 0; i < threadCount; i++)
+            threads.emplace_back([this] { workerLoop(); });
+    }
+
+    // jobs still waiting are dropped; a decode in progress finishes first
+    ~AssetLoader()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+            waiting.clear();
+        }
+        wake.notify_all();
+        for (std::thread& t : threads) t.join();
+    }
+
+    AssetLoader(const AssetLoader&) = delete;
+    AssetLoader& operator=(const AssetLoader&) = delete;
+
+    void load(Decode decode, UploadStep upload)
+    {
+        outstanding++;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            waiting.push_back({ std::move(decode), std::move(upload) });
+        }
+        wake.notify_one();
+    }
+
+    // render thread, once per frame: upload steps of decoded jobs, oldest first,
+    // until budgetMs is used up (one step always runs); returns the steps run
+    size_t pump(double budgetMs)
+    {
+        auto start = std::chrono::steady_clock::now();
+        size_t steps = 0;
+        while (true) {
+            if (!current.upload) {
+                std::lock_guard<std::mutex> lock(mutex);
+                if (ready.empty()) break;
+                current = std::move(ready.front());
+                ready.pop_front();
+            }
+            bool done = current.upload();
+            steps++;
+            if (done) {
+                current = Job();
+                finished();
+            }
+            std::chrono::duration<double, std::milli> spent = std::chrono::steady_clock::now() - start;
+            if (spent.count() >= budgetMs) break;
+        }
+        return steps;
+    }
+
+    // pump with no budget until every job is resident (or failed)
+    void finishAll()
+    {
+        while (!idle()) {
+            pump(1.0e9);
+            std::unique_lock<std::mutex> lock(mutex);
+            done.wait(lock, [this] { return !ready.empty() || outstanding == 0; });
+        }
+    }
+
+    // jobs not yet resident
+    size_t pending() const { return outstanding; }
+    bool idle() const { return outstanding == 0; }
+
+private:
+    struct Job {
+        Decode decode;
+        UploadStep upload;
+    };
+
+    std::vector<std::thread> threads;
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable done;
+    std::deque<Job> waiting; // to decode
+    std::deque<Job> ready;   // decoded, to upload
+    Job current;             // render thread only: the job being uploaded
+    std::atomic<size_t> outstanding{ 0 };
+    bool stopping = false;
+
+    void finished()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        outstanding--;
+        done.notify_all();
+    }
+
+    void workerLoop()
+    {
+        while (true) {
+            std::unique_lock<std::mutex> lock(mutex);
+            wake.wait(lock, [this] { return stopping || !waiting.empty(); });
+            if (stopping) return;
+            Job job = std::move(waiting.front());
+            waiting.pop_front();
+            lock.unlock();
+
+            bool ok = job.decode();
+
+            lock.lock();
+            if (ok) ready.push_back(std::move(job));
+            else outstanding--;
+            done.notify_all();
+        }
+    }
+};
+
+// an 8-bit image straight from stb_image, safe to decode on any thread
+struct DecodedImage {
+    int width = 0, height = 0, components = 0;
+    std::shared_ptr<unsigned char> pixels; // freed with stbi_image_free
+
+    bool load(const std::string& path)
+    {
+        unsigned char* data = stbi_load(path.c_str(), &width, &height, &components, 0);
+        if (!data) {
+            std::cerr << "Failed to load texture: " << path << std::endl;
+            return false;
+        }
+        pixels.reset(data, stbi_image_free);
+        return true;
+    }
+
+    GLenum format() const
+    {
+        if (components == 1) return GL_RED;
+        if (components == 4) return GL_RGBA;
+        return GL_RGB;
+    }
+};
+
+// mipmapped, repeating 2D texture, the same setup as loadTexture / TextureFromFile
+inline GLuint createTexture2D(const DecodedImage& image)
+{
+    GLuint tex;
+    glGenTextures(1, &tex);
+    glBindTexture(GL_TEXTURE_2D, tex);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1); // RGB rows aren't always 4-byte aligned
+    glTexImage2D(GL_TEXTURE_2D, 0, image.format(), image.width, image.height, 0, image.format(), GL_UNSIGNED_BYTE,
+                 image.pixels.get());
+    glGenerateMipmap(GL_TEXTURE_2D);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    return tex;
+}
+
+// 1x1 stand-ins drawn until the real texture is resident
+inline GLuint createPlaceholderTexture2D(unsigned char r, unsigned char g, unsigned char b)
+{
+    const unsigned char texel[3] = { r, g, b };
+    GLuint tex;
+    glGenTextures(1, &tex);
+    glBindTexture(GL_TEXTURE_2D, tex);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, 1, 1, 0, GL_RGB, GL_UNSIGNED_BYTE, texel);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    return tex;
+}
+
+inline GLuint createPlaceholderCubemap(unsigned char r, unsigned char g, unsigned char b)
+{
+    const unsigned char texel[3] = { r, g, b };
+    GLuint tex;
+    glGenTextures(1, &tex);
+    glBindTexture(GL_TEXTURE_CUBE_MAP, tex);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    for (GLenum face = 0; face < 6; face++)
+        glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + face, 0, GL_RGB, 1, 1, 0, GL_RGB, GL_UNSIGNED_BYTE, texel);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    return tex;
+}
+
+// decode path in the background, then replace texture (a placeholder, deleted
+// on the swap) with the real one; texture is only written on the render thread
+inline void loadTextureAsync(AssetLoader& loader, const std::string& path, GLuint& texture)
+{
+    std::shared_ptr<DecodedImage> image = std::make_shared<DecodedImage>();
+    loader.load([image, path] { return image->load(path); },
+                [image, &texture] {
+                    GLuint tex = createTexture2D(*image);
+                    if (texture) glDeleteTextures(1, &texture);
+                    texture = tex;
+                    return true;
+                });
+}
+
+// one decode job per face, so the six faces decode in parallel; each face is
+// uploaded into a fresh cubemap as it arrives, and the cubemap replaces the
+// placeholder in texture once all six are in. A face that fails to load stays
+// black, as with loadCubemap.
+inline void loadCubemapAsync(AssetLoader& loader, const std::vector<std::string>& faces, GLuint& texture)
+{
+    struct Cubemap {
+        GLuint id = 0;
+        size_t facesLeft = 0;
+    };
+    std::shared_ptr<Cubemap> cubemap = std::make_shared<Cubemap>();
+    cubemap->facesLeft = faces.size();
+    auto faceDone = [cubemap, &texture] {
+        if (--cubemap->facesLeft > 0) return;
+        glBindTexture(GL_TEXTURE_CUBE_MAP, cubemap->id);
+        glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+        if (texture) glDeleteTextures(1, &texture);
+        texture = cubemap->id;
+    };
+    for (GLenum face = 0; face < faces.size(); face++) {
+        std::shared_ptr<DecodedImage> image = std::make_shared<DecodedImage>();
+        std::string path = faces[face];
+        loader.load([image, path] {
+                        if (!image->load(path)) std::cout << "Cubemap texture failed to load at path: " << path << std::endl;
+                        return true; // still counts towards the six faces
+                    },
+                    [image, cubemap, face, faceDone] {
+                        if (!cubemap->id) glGenTextures(1, &cubemap->id);
+                        glBindTexture(GL_TEXTURE_CUBE_MAP, cubemap->id);
+                        if (image->pixels) {
+                            // assume RGB images for skybox
+                            glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+                            glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + face, 0, GL_RGB, image->width, image->height, 0,
+                                         GL_RGB, GL_UNSIGNED_BYTE, image->pixels.get());
+                        }
+                        faceDone();
+                        return true;
+                    });
+    }
+}
+
+#endif
@@ -0,0 +1,437 @@
+// Collision microbenchmarks: no window, no GL context, only the collision headers.
+//
+// Build (from this directory, glm on the include path):
+//   g++ -std=c++17 -O2 -pthread -I.. -I<path to glm> collision_bench.cpp -o collision_bench
+//   cl /std:c++17 /O2 /EHsc /I.. /I<path to glm> collision_bench.cpp
+//
+// Run:
+//   ./collision_bench [--out results.json] [--max-boxes 1000000] [--min-time 0.2] [--threads N]
+//
+// Generates synthetic grid mazes (obstacles) and platform fields from 10^2 up to
+// --max-boxes boxes, then times collidesWithAnyObstacle (sphere, capsule, OBB), moveSphere,
+// highestPlatformTopAtXZ and the raw sphere-vs-boxes kernels over randomized and
+// trajectory-coherent query streams. Results (ns/query, queries/s and, on Linux
+// when perf events are permitted, cache misses/references) are written as JSON.
+
+#include "../collision_world.h"
+#include "../box_coalesce.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+using namespace std;
+
+// ---------- hardware counters ----------
+// cache misses/references through perf_event_open; reports unavailable elsewhere
+// or when the kernel refuses (perf_event_paranoid, containers)
+class CacheCounters {
+public:
+    CacheCounters()
+    {
+#if defined(__linux__)
+        missFd = open(PERF_COUNT_HW_CACHE_MISSES, -1);
+        if (missFd >= 0) refFd = open(PERF_COUNT_HW_CACHE_REFERENCES, missFd);
+#endif
+    }
+
+    ~CacheCounters()
+    {
+#if defined(__linux__)
+        if (refFd >= 0) close(refFd);
+        if (missFd >= 0) close(missFd);
+#endif
+    }
+
+    bool available() const { return missFd >= 0; }
+
+    void start()
+    {
+#if defined(__linux__)
+        if (missFd < 0) return;
+        ioctl(missFd, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+        ioctl(missFd, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+#endif
+    }
+
+    void stop(long long& misses, long long& references)
+    {
+        misses = references = -1;
+#if defined(__linux__)
+        if (missFd < 0) return;
+        ioctl(missFd, PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+        long long v = 0;
+        if (read(missFd, &v, sizeof(v)) == sizeof(v)) misses = v;
+        if (refFd >= 0 && read(refFd, &v, sizeof(v)) == sizeof(v)) references = v;
+#endif
+    }
+
+private:
+    int missFd = -1;
+    int refFd = -1;
+
+#if defined(__linux__)
+    static int open(unsigned long long config, int groupFd)
+    {
+        perf_event_attr attr;
+        memset(&attr, 0, sizeof(attr));
+        attr.type = PERF_TYPE_HARDWARE;
+        attr.size = sizeof(attr);
+        attr.config = config;
+        attr.disabled = groupFd < 0 ? 1 : 0;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        return static_cast<int>(syscall(__NR_perf_event_open, &attr, 0, -1, groupFd, 0));
+    }
+#endif
+};
+
+// ---------- synthetic levels ----------
+const float MAZE_CELL = 4.0f;     // corridor pitch
+const float WALL_THICKNESS = 1.0f; // same as the hand-built maze
+const float WALL_HEIGHT = 2.5f;
+
+// grid maze: each cell gets an east and/or south wall, about 60% of them present
+vector<Box> generateMaze(size_t count, mt19937& rng, float& halfExtent)
+{
+    int side = max(2, static_cast<int>(ceil(sqrt(count / 1.2))));
+    halfExtent = side * MAZE_CELL * 0.5f;
+    uniform_real_distribution<float> coin(0.0f, 1.0f);
+    vector<Box> walls;
+    walls.reserve(count);
+    while (walls.size() < count) {
+        for (int z = 0; z < side && walls.size() < count; z++) {
+            for (int x = 0; x < side && walls.size() < count; x++) {
+                float x0 = -halfExtent + x * MAZE_CELL, z0 = -halfExtent + z * MAZE_CELL;
+                if (coin(rng) < 0.6f)
+                    walls.push_back({ glm::vec3(x0 + MAZE_CELL - WALL_THICKNESS, 0.0f, z0), glm::vec3(x0 + MAZE_CELL, WALL_HEIGHT, z0 + MAZE_CELL) });
+                if (walls.size() < count && coin(rng) < 0.6f)
+                    walls.push_back({ glm::vec3(x0, 0.0f, z0 + MAZE_CELL - WALL_THICKNESS), glm::vec3(x0 + MAZE_CELL, WALL_HEIGHT, z0 + MAZE_CELL) });
+            }
+        }
+    }
+    return walls;
+}
+
+// ground plus raised platforms scattered over the same area
+vector<Box> generatePlatforms(size_t count, float halfExtent, mt19937& rng)
+{
+    uniform_real_distribution<float> pos(-halfExtent, halfExtent), size(1.0f, 8.0f), height(0.2f, 3.0f);
+    vector<Box> plats;
+    plats.reserve(count);
+    plats.push_back({ glm::vec3(-halfExtent, -0.1f, -halfExtent), glm::vec3(halfExtent, 0.0f, halfExtent) });
+    while (plats.size() < count) {
+        glm::vec3 p(pos(rng), height(rng), pos(rng));
+        plats.push_back({ p, p + glm::vec3(size(rng), 1.0f, size(rng)) });
+    }
+    return plats;
+}
+
+// ---------- query streams ----------
+struct QueryStream {
+    string name;
+    vector<glm::vec3> positions;
+    vector<glm::vec3> moves;
+};
+
+QueryStream randomStream(size_t count, float halfExtent, mt19937& rng)
+{
+    uniform_real_distribution<float> pos(-halfExtent, halfExtent), dir(-1.0f, 1.0f);
+    QueryStream s{ "random", {}, {} };
+    for (size_t i = 0; i < count; i++) {
+        s.positions.push_back(glm::vec3(pos(rng), 0.0f, pos(rng)));
+        s.moves.push_back(glm::vec3(dir(rng), 0.0f, dir(rng)) * 0.066f);
+    }
+    return s;
+}
+
+// a few walkers taking 60 Hz steps at the player's speed, turning now and then,
+// so consecutive queries hit the same nodes/cells like a real tick does
+QueryStream coherentStream(size_t count, float halfExtent, mt19937& rng)
+{
+    const int walkers = 16;
+    const float step = 4.0f / 60.0f;
+    uniform_real_distribution<float> pos(-halfExtent, halfExtent), angle(0.0f, 6.2831853f), coin(0.0f, 1.0f);
+    QueryStream s{ "coherent", {}, {} };
+    size_t perWalker = (count + walkers - 1) / walkers;
+    for (int w = 0; w < walkers; w++) {
+        glm::vec3 p(pos(rng), 0.0f, pos(rng));
+        float a = angle(rng);
+        for (size_t i = 0; i < perWalker && s.positions.size() < count; i++) {
+            if (coin(rng) < 0.02f) a = angle(rng);
+            glm::vec3 move(cos(a) * step, 0.0f, sin(a) * step);
+            s.positions.push_back(p);
+            s.moves.push_back(move);
+            p += move;
+            if (fabs(p.x) > halfExtent || fabs(p.z) > halfExtent) p = glm::vec3(pos(rng), 0.0f, pos(rng));
+        }
+    }
+    return s;
+}
+
+// ---------- timing ----------
+struct Result {
+    string query, variant, stream;
+    size_t boxes = 0;
+    size_t queries = 0;
+    double nsPerQuery = 0.0;
+    double queriesPerSec = 0.0;
+    long long cacheMisses = -1, cacheReferences = -1;
+    size_t hits = 0;
+};
+
+double minTimeSec = 0.2;
+CacheCounters counters;
+
+// runs fn(i) over the stream in passes until minTimeSec has elapsed
+template <typename Fn>
+Result timeQueries(const string& query, const string& variant, const QueryStream& stream, size_t boxes, Fn fn)
+{
+    using clock = chrono::steady_clock;
+    Result r;
+    r.query = query; r.variant = variant; r.stream = stream.name; r.boxes = boxes;
+    size_t n = stream.positions.size();
+    size_t hits = 0;
+    // warm-up pass over a slice
+    for (size_t i = 0; i < min<size_t>(n, 1024); i++) hits += fn(i);
+
+    counters.start();
+    auto t0 = clock::now();
+    double elapsed = 0.0;
+    size_t done = 0;
+    while (elapsed < minTimeSec) {
+        size_t chunk = min<size_t>(n, 4096);
+        size_t base = done % n;
+        for (size_t k = 0; k < chunk; k++) hits += fn((base + k) % n);
+        done += chunk;
+        elapsed = chrono::duration<double>(clock::now() - t0).count();
+    }
+    counters.stop(r.cacheMisses, r.cacheReferences);
+
+    r.queries = done;
+    r.nsPerQuery = elapsed * 1e9 / done;
+    r.queriesPerSec = done / elapsed;
+    r.hits = hits;
+    return r;
+}
+
+const char* simdName(SimdLevel level)
+{
+    switch (level) {
+    case SimdLevel::AVX2: return "avx2";
+    case SimdLevel::SSE: return "sse";
+    default: return "scalar";
+    }
+}
+
+const char* broadphaseName(Broadphase b)
+{
+    switch (b) {
+    case Broadphase::BVH: return "bvh";
+    case Broadphase::Grid: return "grid";
+    case Broadphase::SweepAndPrune: return "sweep_and_prune";
+    default: return "brute_force";
+    }
+}
+
+struct CoalesceStat {
+    size_t boxes, after;
+    double ms;
+};
+
+string toJson(const vector<Result>& results, const vector<pair<size_t, double>>& buildMs, const vector<CoalesceStat>& coalesce,
+              SimdLevel simd, unsigned int threads)
+{
+    ostringstream o;
+    o << "{\n  \"simd_level\": \"" << simdName(simd) << "\",\n";
+    o << "  \"worker_threads\": " << threads << ",\n";
+    o << "  \"cache_counters\": " << (counters.available() ? "true" : "false") << ",\n";
+    o << "  \"min_time_sec\": " << minTimeSec << ",\n";
+    o << "  \"build_ms\": [";
+    for (size_t i = 0; i < buildMs.size(); i++)
+        o << (i ? ", " : "") << "{\"boxes\": " << buildMs[i].first << ", \"ms\": " << buildMs[i].second << "}";
+    o << "],\n  \"coalesce\": [";
+    for (size_t i = 0; i < coalesce.size(); i++)
+        o << (i ? ", " : "") << "{\"boxes\": " << coalesce[i].boxes << ", \"after\": " << coalesce[i].after << ", \"ms\": " << coalesce[i].ms << "}";
+    o << "],\n  \"results\": [\n";
+    for (size_t i = 0; i < results.size(); i++) {
+        const Result& r = results[i];
+        o << "    {\"query\": \"" << r.query << "\", \"variant\": \"" << r.variant << "\", \"stream\": \"" << r.stream
+          << "\", \"boxes\": " << r.boxes << ", \"queries\": " << r.queries
+          << ", \"ns_per_query\": " << r.nsPerQuery << ", \"queries_per_sec\": " << r.queriesPerSec
+          << ", \"hits\": " << r.hits << ", \"cache_misses\": ";
+        if (r.cacheMisses >= 0) o << r.cacheMisses; else o << "null";
+        o << ", \"cache_references\": ";
+        if (r.cacheReferences >= 0) o << r.cacheReferences; else o << "null";
+        o << "}" << (i + 1 < results.size() ? "," : "") << "\n";
+    }
+    o << "  ]\n}\n";
+    return o.str();
+}
+
+int main(int argc, char** argv)
+{
+    string outPath;
+    size_t maxBoxes = 1000000;
+    unsigned int threads = 0;
+    for (int i = 1; i < argc; i++) {
+        string a = argv[i];
+        if (a == "--out" && i + 1 < argc) outPath = argv[++i];
+        else if (a == "--max-boxes" && i + 1 < argc) maxBoxes = strtoull(argv[++i], NULL, 10);
+        else if (a == "--min-time" && i + 1 < argc) minTimeSec = atof(argv[++i]);
+        else if (a == "--threads" && i + 1 < argc) threads = static_cast<unsigned int>(atoi(argv[++i]));
+        else {
+            std::cerr << "usage: " << argv[0] << " [--out file.json] [--max-boxes N] [--min-time sec] [--threads N]\n";
+            return 1;
+        }
+    }
+
+    const float radius = 0.5f;
+    const size_t streamLength = 1 << 16;
+    SimdLevel detected = detectSimdLevel();
+    WorkerPool pool(threads);
+    vector<Result> results;
+    vector<pair<size_t, double>> buildMs;
+    vector<CoalesceStat> coalesce;
+
+    for (size_t n = 100; n <= maxBoxes; n *= 10) {
+        mt19937 rng(static_cast<unsigned int>(n));
+        float halfExtent = 0.0f;
+        vector<Box> obstacles = generateMaze(n, rng, halfExtent);
+        vector<Box> platforms = generatePlatforms(n, halfExtent, rng);
+
+        // how much load-time coalescing would shrink this maze (queries below run on the raw set)
+        {
+            vector<Box> merged = obstacles;
+            auto c0 = chrono::steady_clock::now();
+            coalesceBoxes(merged);
+            coalesce.push_back({ n, merged.size(), chrono::duration<double, milli>(chrono::steady_clock::now() - c0).count() });
+        }
+
+        auto t0 = chrono::steady_clock::now();
+        CollisionWorld world(obstacles, platforms);
+        world.rebuild();
+        buildMs.push_back({ n, chrono::duration<double, milli>(chrono::steady_clock::now() - t0).count() });
+        std::cerr << "boxes " << n << ": build " << buildMs.back().second << " ms" << std::endl;
+
+        QueryStream streams[2] = { randomStream(streamLength, halfExtent, rng), coherentStream(streamLength, halfExtent, rng) };
+        for (const QueryStream& s : streams) {
+            // collidesWithAnyObstacle through each broadphase
+            for (Broadphase b : { Broadphase::BruteForce, Broadphase::BVH, Broadphase::Grid }) {
+                world.broadphase = b;
+                results.push_back(timeQueries("collides_with_any_obstacle", broadphaseName(b), s, n,
+                    [&](size_t i) { return world.collidesWithAnyObstacle(s.positions[i], radius) ? 1 : 0; }));
+            }
+            // the same query for the other shapes (standing capsule, yawed prop box)
+            for (Broadphase b : { Broadphase::BruteForce, Broadphase::BVH, Broadphase::Grid }) {
+                world.broadphase = b;
+                results.push_back(timeQueries("collides_capsule", broadphaseName(b), s, n, [&](size_t i) {
+                    Capsule c{ s.positions[i], s.positions[i] + glm::vec3(0.0f, 1.5f, 0.0f), radius };
+                    return world.collidesWithAnyObstacle(c) ? 1 : 0;
+                }));
+                results.push_back(timeQueries("collides_obb", broadphaseName(b), s, n, [&](size_t i) {
+                    float yaw = static_cast<float>(i) * 0.1f;
+                    glm::mat3 axes(1.0f);
+                    axes[0] = glm::vec3(cos(yaw), 0.0f, sin(yaw));
+                    axes[2] = glm::vec3(-sin(yaw), 0.0f, cos(yaw));
+                    return world.collidesWithAnyObstacle(OBB{ s.positions[i], glm::vec3(1.0f, 0.5f, 0.3f), axes }) ? 1 : 0;
+                }));
+            }
+            // full player step: sweep + slide + ground snap
+            for (Broadphase b : { Broadphase::BVH, Broadphase::Grid }) {
+                world.broadphase = b;
+                results.push_back(timeQueries("move_sphere", broadphaseName(b), s, n,
+                    [&](size_t i) { glm::vec3 p = s.positions[i]; return world.moveSphere(p, radius, s.moves[i]) ? 1 : 0; }));
+            }
+            // ground snap: linear scan vs height grid
+            results.push_back(timeQueries("highest_platform_top", "brute_force", s, n,
+                [&](size_t i) { float y; return world.highestPlatformTopAtXZBruteForce(s.positions[i].x, s.positions[i].z, y) ? 1 : 0; }));
+            results.push_back(timeQueries("highest_platform_top", "height_grid", s, n,
+                [&](size_t i) { float y; return world.getHeights().highestTopAt(s.positions[i].x, s.positions[i].z, y) ? 1 : 0; }));
+        }
+
+        // narrowphase throughput: one sphere against every box (ns per box = ns_per_query / boxes)
+        const QueryStream& s = streams[0];
+        results.push_back(timeQueries("sphere_intersects_aabb", "aos_loop", s, n, [&](size_t i) {
+            size_t hits = 0;
+            for (const Box& b : obstacles) hits += sphereIntersectsAABB(s.positions[i], radius, b) ? 1 : 0;
+            return hits;
+        }));
+        BoxSoA soa;
+        soa.assign(obstacles);
+        for (SimdLevel level : { SimdLevel::Scalar, SimdLevel::SSE, SimdLevel::AVX2 }) {
+            if (static_cast<int>(level) > static_cast<int>(detected)) continue;
+            SphereBoxesKernel kernel = kernelForLevel(level);
+            results.push_back(timeQueries("sphere_vs_boxes_kernel", simdName(level), s, n,
+                [&](size_t i) { return kernel(soa, 0, soa.size(), s.positions[i], radius) ? 1 : 0; }));
+        }
+
+        // many agents per tick through the batch API
+        world.broadphase = Broadphase::BVH;
+        vector<float> radii(s.positions.size(), radius);
+        vector<glm::vec3> outPos(s.positions.size());
+        vector<uint8_t> outHit(s.positions.size());
+        QueryStream batch{ "coherent_batch_of_" + to_string(s.positions.size()), { glm::vec3(0.0f) }, {} };
+        Result r = timeQueries("move_spheres_batch", "bvh_pool", batch, n, [&](size_t) {
+            world.moveSpheresBatch(streams[1].positions.data(), radii.data(), streams[1].moves.data(), streams[1].positions.size(),
+                                   outPos.data(), outHit.data(), &pool);
+            return static_cast<size_t>(outHit[0]);
+        });
+        // report per agent, not per batch
+        r.queries *= s.positions.size();
+        r.nsPerQuery /= s.positions.size();
+        r.queriesPerSec *= s.positions.size();
+        results.push_back(r);
+
+        // persistent agents walking the coherent stream: per-tick query vs incremental sweep and prune
+        const size_t agentCount = 1024;
+        const size_t spacing = streams[1].positions.size() / agentCount;
+        vector<uint32_t> agents;
+        for (size_t a = 0; a < agentCount; a++) agents.push_back(world.addAgent(streams[1].positions[a * spacing], radius));
+        vector<glm::vec3> tickPos(agentCount), tickMove(agentCount);
+        QueryStream ticks{ "coherent_" + to_string(agentCount) + "_agents", vector<glm::vec3>(spacing), {} };
+        for (Broadphase b : { Broadphase::BVH, Broadphase::SweepAndPrune }) {
+            world.broadphase = b;
+            Result t = timeQueries("move_agents_tick", broadphaseName(b), ticks, n, [&](size_t step) {
+                for (size_t a = 0; a < agentCount; a++) {
+                    tickPos[a] = streams[1].positions[a * spacing + step];
+                    tickMove[a] = streams[1].moves[a * spacing + step];
+                }
+                world.moveAgentsBatch(agents.data(), tickPos.data(), radii.data(), tickMove.data(), agentCount,
+                                      outPos.data(), outHit.data(), &pool);
+                return static_cast<size_t>(outHit[0]);
+            });
+            t.queries *= agentCount;
+            t.nsPerQuery /= agentCount;
+            t.queriesPerSec *= agentCount;
+            results.push_back(t);
+        }
+        for (uint32_t a : agents) world.removeAgent(a);
+    }
+
+    string json = toJson(results, buildMs, coalesce, detected, pool.workerCount());
+    if (outPath.empty()) {
+        std::cout << json;
+    }
+    else {
+        ofstream f(outPath);
+        f << json;
+        std::cerr << "wrote " << outPath << std::endl;
+    }
+    return 0;
+}
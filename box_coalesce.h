@@ -0,0 +1,96 @@
+#ifndef BOX_COALESCE_H
+#define BOX_COALESCE_H
+
+#include <glm/glm.hpp>
+
+#include "collision.h"
+#include "obstacle_bvh.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+// Level preprocessing: replaces boxes by fewer boxes covering exactly the same
+// volume. Two rules are applied until nothing changes:
+//  - a box inside another box is dropped
+//  - boxes with the same cross-section on two axes that touch or overlap on the
+//    third are merged into one (their union is exactly a box)
+// Overlaps whose union is not a box (e.g. wall corners) are left alone.
+// Box order is not preserved, so run this before building any broadphase.
+
+inline bool boxContains(const Box& outer, const Box& inner)
+{
+    return outer.min.x <= inner.min.x && outer.min.y <= inner.min.y && outer.min.z <= inner.min.z &&
+           outer.max.x >= inner.max.x && outer.max.y >= inner.max.y && outer.max.z >= inner.max.z;
+}
+
+// drop every box contained in another one (of identical boxes the first is kept)
+inline bool removeContainedBoxes(std::vector<Box>& boxes)
+{
+    ObstacleBVH bvh;
+    bvh.build(boxes);
+    std::vector<uint8_t> drop(boxes.size(), 0);
+    std::vector<uint32_t> overlapping;
+    bool changed = false;
+    for (uint32_t i = 0; i < boxes.size(); i++) {
+        overlapping.clear();
+        bvh.query(boxes[i], overlapping);
+        for (uint32_t j : overlapping) {
+            if (j == i || drop[j] || !boxContains(boxes[j], boxes[i])) continue;
+            if (boxContains(boxes[i], boxes[j]) && j > i) continue; // identical: keep the lower index
+            drop[i] = 1;
+            changed = true;
+            break;
+        }
+    }
+    if (changed) {
+        size_t out = 0;
+        for (size_t i = 0; i < boxes.size(); i++)
+            if (!drop[i]) boxes[out++] = boxes[i];
+        boxes.resize(out);
+    }
+    return changed;
+}
+
+// merge runs of boxes sharing the same extents on the two other axes and touching along axis
+inline bool mergeBoxesAlongAxis(std::vector<Box>& boxes, int axis)
+{
+    int u = (axis + 1) % 3, v = (axis + 2) % 3;
+    auto sameSection = [&](const Box& a, const Box& b) {
+        return a.min[u] == b.min[u] && a.max[u] == b.max[u] && a.min[v] == b.min[v] && a.max[v] == b.max[v];
+    };
+    std::sort(boxes.begin(), boxes.end(), [&](const Box& a, const Box& b) {
+        if (a.min[u] != b.min[u]) return a.min[u] < b.min[u];
+        if (a.max[u] != b.max[u]) return a.max[u] < b.max[u];
+        if (a.min[v] != b.min[v]) return a.min[v] < b.min[v];
+        if (a.max[v] != b.max[v]) return a.max[v] < b.max[v];
+        return a.min[axis] < b.min[axis];
+    });
+
+    size_t out = 0;
+    for (size_t i = 0; i < boxes.size(); i++) {
+        if (out > 0 && sameSection(boxes[out - 1], boxes[i]) && boxes[i].min[axis] <= boxes[out - 1].max[axis]) {
+            boxes[out - 1].max[axis] = std::max(boxes[out - 1].max[axis], boxes[i].max[axis]);
+            continue;
+        }
+        boxes[out++] = boxes[i];
+    }
+    bool changed = out != boxes.size();
+    boxes.resize(out);
+    return changed;
+}
+
+// returns how many boxes were removed
+inline size_t coalesceBoxes(std::vector<Box>& boxes)
+{
+    size_t before = boxes.size();
+    bool changed = true;
+    while (changed) {
+        changed = removeContainedBoxes(boxes);
+        for (int axis = 0; axis < 3; axis++)
+            if (mergeBoxesAlongAxis(boxes, axis)) changed = true;
+    }
+    return before - boxes.size();
+}
+
+#endif
@@ -0,0 +1,203 @@
+#ifndef BOX_SOA_H
+#define BOX_SOA_H
+
+#include <glm/glm.hpp>
+
+#include "collision.h"
+
+#include <cstddef>
+#include <vector>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define BOX_SOA_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#define BOX_SOA_TARGET_AVX2
+#else
+#define BOX_SOA_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#else
+#define BOX_SOA_X86 0
+#endif
+
+// Structure-of-arrays copy of a set of boxes for the SIMD sphere tests.
+// Every array is followed by at least 7 padding entries, so a kernel may load
+// a full 8-lane block starting at any valid index; padding boxes never hit.
+class BoxSoA {
+public:
+    std::vector<float> minX, minY, minZ, maxX, maxY, maxZ;
+
+    void assign(const std::vector<Box>& boxes)
+    {
+        clear();
+        reserveFor(boxes.size());
+        for (const Box& b : boxes) push(b);
+    }
+
+    void clear()
+    {
+        count = 0;
+        for (std::vector<float>* v : { &minX, &minY, &minZ }) v->assign(8, 1e30f);
+        for (std::vector<float>* v : { &maxX, &maxY, &maxZ }) v->assign(8, -1e30f);
+    }
+
+    void push(const Box& b)
+    {
+        reserveFor(count + 1);
+        set(count++, b);
+    }
+
+    void set(size_t i, const Box& b)
+    {
+        minX[i] = b.min.x; minY[i] = b.min.y; minZ[i] = b.min.z;
+        maxX[i] = b.max.x; maxY[i] = b.max.y; maxZ[i] = b.max.z;
+    }
+
+    // move the last box into i and shrink by one
+    void removeSwap(size_t i)
+    {
+        size_t last = count - 1;
+        if (i != last) set(i, get(last));
+        set(last, sentinel());
+        count--;
+    }
+
+    Box get(size_t i) const
+    {
+        return { glm::vec3(minX[i], minY[i], minZ[i]), glm::vec3(maxX[i], maxY[i], maxZ[i]) };
+    }
+
+    size_t size() const { return count; }
+
+private:
+    size_t count = 0;
+
+    static Box sentinel() { return { glm::vec3(1e30f), glm::vec3(-1e30f) }; }
+
+    void reserveFor(size_t n)
+    {
+        size_t padded = ((n + 7 + 7) / 8) * 8;
+        if (minX.size() >= padded) return;
+        for (std::vector<float>* v : { &minX, &minY, &minZ }) v->resize(padded, 1e30f);
+        for (std::vector<float>* v : { &maxX, &maxY, &maxZ }) v->resize(padded, -1e30f);
+    }
+};
+
+// ---------- sphere vs many boxes kernels ----------
+// All kernels answer: does the sphere overlap any of soa[first, first + count)?
+// Same clamp-and-compare math as sphereIntersectsAABB, so results match exactly.
+typedef bool (*SphereBoxesKernel)(const BoxSoA& soa, size_t first, size_t count, const glm::vec3& center, float radius);
+
+inline bool sphereOverlapsAnyScalar(const BoxSoA& soa, size_t first, size_t count, const glm::vec3& center, float radius)
+{
+    float r2 = radius * radius;
+    for (size_t i = first; i < first + count; i++) {
+        float x = std::max(soa.minX[i], std::min(center.x, soa.maxX[i])) - center.x;
+        float y = std::max(soa.minY[i], std::min(center.y, soa.maxY[i])) - center.y;
+        float z = std::max(soa.minZ[i], std::min(center.z, soa.maxZ[i])) - center.z;
+        if (x * x + y * y + z * z < r2) return true;
+    }
+    return false;
+}
+
+#if BOX_SOA_X86
+// 4 boxes per iteration (SSE2 is baseline on x86-64)
+inline bool sphereOverlapsAnySSE(const BoxSoA& soa, size_t first, size_t count, const glm::vec3& center, float radius)
+{
+    const __m128 cx = _mm_set1_ps(center.x), cy = _mm_set1_ps(center.y), cz = _mm_set1_ps(center.z);
+    const __m128 r2 = _mm_set1_ps(radius * radius);
+    for (size_t i = 0; i < count; i += 4) {
+        size_t o = first + i;
+        __m128 dx = _mm_sub_ps(_mm_max_ps(_mm_loadu_ps(&soa.minX[o]), _mm_min_ps(cx, _mm_loadu_ps(&soa.maxX[o]))), cx);
+        __m128 dy = _mm_sub_ps(_mm_max_ps(_mm_loadu_ps(&soa.minY[o]), _mm_min_ps(cy, _mm_loadu_ps(&soa.maxY[o]))), cy);
+        __m128 dz = _mm_sub_ps(_mm_max_ps(_mm_loadu_ps(&soa.minZ[o]), _mm_min_ps(cz, _mm_loadu_ps(&soa.maxZ[o]))), cz);
+        __m128 d2 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz));
+        int mask = _mm_movemask_ps(_mm_cmplt_ps(d2, r2));
+        size_t remaining = count - i;
+        if (remaining < 4) mask &= (1 << remaining) - 1;
+        if (mask) return true;
+    }
+    return false;
+}
+
+// 8 boxes per iteration; the distance sum is kept in the same order as the scalar path
+BOX_SOA_TARGET_AVX2
+inline bool sphereOverlapsAnyAVX2(const BoxSoA& soa, size_t first, size_t count, const glm::vec3& center, float radius)
+{
+    const __m256 cx = _mm256_set1_ps(center.x), cy = _mm256_set1_ps(center.y), cz = _mm256_set1_ps(center.z);
+    const __m256 r2 = _mm256_set1_ps(radius * radius);
+    for (size_t i = 0; i < count; i += 8) {
+        size_t o = first + i;
+        __m256 dx = _mm256_sub_ps(_mm256_max_ps(_mm256_loadu_ps(&soa.minX[o]), _mm256_min_ps(cx, _mm256_loadu_ps(&soa.maxX[o]))), cx);
+        __m256 dy = _mm256_sub_ps(_mm256_max_ps(_mm256_loadu_ps(&soa.minY[o]), _mm256_min_ps(cy, _mm256_loadu_ps(&soa.maxY[o]))), cy);
+        __m256 dz = _mm256_sub_ps(_mm256_max_ps(_mm256_loadu_ps(&soa.minZ[o]), _mm256_min_ps(cz, _mm256_loadu_ps(&soa.maxZ[o]))), cz);
+        __m256 d2 = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(dx, dx), _mm256_mul_ps(dy, dy)), _mm256_mul_ps(dz, dz));
+        int mask = _mm256_movemask_ps(_mm256_cmp_ps(d2, r2, _CMP_LT_OQ));
+        size_t remaining = count - i;
+        if (remaining < 8) mask &= (1 << remaining) - 1;
+        if (mask) return true;
+    }
+    return false;
+}
+#endif
+
+enum class SimdLevel { Scalar, SSE, AVX2 };
+
+// best level the running CPU (and OS, for the AVX register state) supports
+inline SimdLevel detectSimdLevel()
+{
+#if BOX_SOA_X86
+#if defined(_MSC_VER) && !defined(__clang__)
+    int info[4];
+    __cpuid(info, 0);
+    int maxLeaf = info[0];
+    __cpuid(info, 1);
+    bool sse2 = (info[3] & (1 << 26)) != 0;
+    bool osxsave = (info[2] & (1 << 27)) != 0;
+    bool avx = (info[2] & (1 << 28)) != 0;
+    bool avx2 = false;
+    if (maxLeaf >= 7) {
+        __cpuidex(info, 7, 0);
+        avx2 = (info[1] & (1 << 5)) != 0;
+    }
+    bool ymmState = osxsave && avx && (_xgetbv(0) & 6) == 6;
+    if (avx2 && ymmState) return SimdLevel::AVX2;
+    if (sse2) return SimdLevel::SSE;
+#else
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) return SimdLevel::AVX2;
+    if (__builtin_cpu_supports("sse2")) return SimdLevel::SSE;
+#endif
+#endif
+    return SimdLevel::Scalar;
+}
+
+inline SphereBoxesKernel kernelForLevel(SimdLevel level)
+{
+#if BOX_SOA_X86
+    if (level == SimdLevel::AVX2) return sphereOverlapsAnyAVX2;
+    if (level == SimdLevel::SSE) return sphereOverlapsAnySSE;
+#endif
+    (void)level;
+    return sphereOverlapsAnyScalar;
+}
+
+// kernel in use; picked by CPUID on first use, can be overridden to compare paths
+inline SphereBoxesKernel& activeSphereBoxesKernel()
+{
+    static SphereBoxesKernel kernel = kernelForLevel(detectSimdLevel());
+    return kernel;
+}
+
+inline void setSimdLevel(SimdLevel level)
+{
+    activeSphereBoxesKernel() = kernelForLevel(level);
+}
+
+inline bool sphereOverlapsAny(const BoxSoA& soa, size_t first, size_t count, const glm::vec3& center, float radius)
+{
+    return activeSphereBoxesKernel()(soa, first, count, center, radius);
+}
+
+#endif
@@ -0,0 +1,264 @@
+#ifndef COLLISION_H
+#define COLLISION_H
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+// Simple Box struct (AABB)
+struct Box {
+    glm::vec3 min;
+    glm::vec3 max;
+};
+
+// sphere vs AABB collision test
+inline bool sphereIntersectsAABB(const glm::vec3& center, float radius, const Box& b) {
+    float x = std::max(b.min.x, std::min(center.x, b.max.x));
+    float y = std::max(b.min.y, std::min(center.y, b.max.y));
+    float z = std::max(b.min.z, std::min(center.z, b.max.z));
+    float distSq = (x - center.x) * (x - center.x) + (y - center.y) * (y - center.y) + (z - center.z) * (z - center.z);
+    return distSq < (radius * radius);
+}
+
+// ---------- small AABB helpers shared by the broadphases ----------
+inline Box emptyBox() {
+    return { glm::vec3(1e30f), glm::vec3(-1e30f) };
+}
+
+inline void growBox(Box& b, const Box& other) {
+    b.min = glm::min(b.min, other.min);
+    b.max = glm::max(b.max, other.max);
+}
+
+inline void growBox(Box& b, const glm::vec3& p) {
+    b.min = glm::min(b.min, p);
+    b.max = glm::max(b.max, p);
+}
+
+inline float boxSurfaceArea(const Box& b) {
+    glm::vec3 e = b.max - b.min;
+    if (e.x < 0.0f || e.y < 0.0f || e.z < 0.0f) return 0.0f;
+    return 2.0f * (e.x * e.y + e.y * e.z + e.z * e.x);
+}
+
+inline glm::vec3 boxCenter(const Box& b) {
+    return (b.min + b.max) * 0.5f;
+}
+
+inline bool boxesOverlap(const Box& a, const Box& b) {
+    return a.min.x <= b.max.x && a.max.x >= b.min.x &&
+           a.min.y <= b.max.y && a.max.y >= b.min.y &&
+           a.min.z <= b.max.z && a.max.z >= b.min.z;
+}
+
+// bounds of a sphere, used to pick broadphase cells / nodes
+inline Box sphereBounds(const glm::vec3& center, float radius) {
+    return { center - glm::vec3(radius), center + glm::vec3(radius) };
+}
+
+// ---------- swept sphere vs AABB ----------
+// The set of centers where a sphere touches a box is the box grown by the radius
+// with rounded edges: three boxes each grown along one axis, twelve edge
+// cylinders and eight corner spheres. Sweeping the sphere is a ray cast against
+// that union; the first entry over all pieces is the time of impact.
+
+// ray vs AABB entry, only for rays starting outside (tEnter >= 0)
+inline bool rayEntersAABB(const glm::vec3& o, const glm::vec3& d, const glm::vec3& bmin, const glm::vec3& bmax, float& tEnter, int& axis) {
+    float t0 = -1e30f, t1 = 1e30f;
+    axis = -1;
+    for (int a = 0; a < 3; a++) {
+        if (std::fabs(d[a]) < 1e-12f) {
+            if (o[a] < bmin[a] || o[a] > bmax[a]) return false;
+            continue;
+        }
+        float inv = 1.0f / d[a];
+        float ta = (bmin[a] - o[a]) * inv;
+        float tb = (bmax[a] - o[a]) * inv;
+        if (ta > tb) std::swap(ta, tb);
+        if (ta > t0) { t0 = ta; axis = a; }
+        t1 = std::min(t1, tb);
+        if (t0 > t1) return false;
+    }
+    if (axis < 0 || t0 < 0.0f) return false;
+    tEnter = t0;
+    return true;
+}
+
+// does the segment o + t*d, t in [0, 1], touch the AABB (starting inside counts)
+inline bool segmentOverlapsAABB(const glm::vec3& o, const glm::vec3& d, const glm::vec3& bmin, const glm::vec3& bmax) {
+    float t0 = 0.0f, t1 = 1.0f;
+    for (int a = 0; a < 3; a++) {
+        if (std::fabs(d[a]) < 1e-12f) {
+            if (o[a] < bmin[a] || o[a] > bmax[a]) return false;
+            continue;
+        }
+        float inv = 1.0f / d[a];
+        float ta = (bmin[a] - o[a]) * inv;
+        float tb = (bmax[a] - o[a]) * inv;
+        if (ta > tb) std::swap(ta, tb);
+        t0 = std::max(t0, ta);
+        t1 = std::min(t1, tb);
+        if (t0 > t1) return false;
+    }
+    return true;
+}
+
+// does the segment pass through the inside of b, at least eps in from every face;
+// grazing a face or edge doesn't count
+inline bool segmentCrossesAABBInside(const glm::vec3& o, const glm::vec3& d, const Box& b, float eps) {
+    glm::vec3 lo = b.min + glm::vec3(eps), hi = b.max - glm::vec3(eps);
+    if (lo.x >= hi.x || lo.y >= hi.y || lo.z >= hi.z) return false; // too thin to have an inside
+    return segmentOverlapsAABB(o, d, lo, hi);
+}
+
+// ray vs sphere entry, only for rays starting outside and moving towards it
+inline bool rayEntersSphere(const glm::vec3& o, const glm::vec3& d, const glm::vec3& c, float r, float& tEnter) {
+    glm::vec3 m = o - c;
+    float b = glm::dot(m, d);
+    float cc = glm::dot(m, m) - r * r;
+    if (cc < 0.0f || b > 0.0f) return false;
+    float a = glm::dot(d, d);
+    float disc = b * b - a * cc;
+    if (a < 1e-12f || disc < 0.0f) return false;
+    tEnter = (-b - std::sqrt(disc)) / a;
+    return true;
+}
+
+// ray vs cylinder along axis a through (cu, cv) on the other two axes, limited to [lo, hi] on a
+inline bool rayEntersAxisCylinder(const glm::vec3& o, const glm::vec3& d, int a, float cu, float cv, float lo, float hi, float r,
+                                  float& tEnter, glm::vec3& normal) {
+    int u = (a + 1) % 3, v = (a + 2) % 3;
+    float mu = o[u] - cu, mv = o[v] - cv;
+    float A = d[u] * d[u] + d[v] * d[v];
+    float B = mu * d[u] + mv * d[v];
+    float C = mu * mu + mv * mv - r * r;
+    if (A < 1e-12f || C < 0.0f || B > 0.0f) return false;
+    float disc = B * B - A * C;
+    if (disc < 0.0f) return false;
+    float t = (-B - std::sqrt(disc)) / A;
+    float pa = o[a] + t * d[a];
+    if (pa < lo || pa > hi) return false;
+    tEnter = t;
+    normal = glm::vec3(0.0f);
+    normal[u] = (mu + t * d[u]) / r;
+    normal[v] = (mv + t * d[v]) / r;
+    return true;
+}
+
+// Time of impact of a sphere moving from center to center + delta against b.
+// Returns true with t in [0, 1] and the outward contact normal. A sphere that
+// already overlaps b reports t = 0 only while moving further in, so it can
+// always back out.
+inline bool sweepSphereAABB(const glm::vec3& center, float radius, const glm::vec3& delta, const Box& b, float& tHit, glm::vec3& normal) {
+    if (sphereIntersectsAABB(center, radius, b)) {
+        glm::vec3 closest = glm::clamp(center, b.min, b.max);
+        glm::vec3 n = center - closest;
+        if (glm::dot(n, n) < 1e-12f) {
+            // center inside the box: push out through the nearest face
+            float best = 1e30f;
+            for (int a = 0; a < 3; a++) {
+                float dMin = center[a] - b.min[a], dMax = b.max[a] - center[a];
+                if (dMin < best) { best = dMin; n = glm::vec3(0.0f); n[a] = -1.0f; }
+                if (dMax < best) { best = dMax; n = glm::vec3(0.0f); n[a] = 1.0f; }
+            }
+        }
+        n = glm::normalize(n);
+        if (glm::dot(delta, n) >= 0.0f) return false;
+        tHit = 0.0f;
+        normal = n;
+        return true;
+    }
+
+    // cheap reject against the square-cornered grown box
+    glm::vec3 r3(radius);
+    if (!segmentOverlapsAABB(center, delta, b.min - r3, b.max + r3)) return false;
+    float t;
+    int axis;
+
+    float best = 1e30f;
+    glm::vec3 n;
+    // faces: the box grown along a single axis
+    for (int a = 0; a < 3; a++) {
+        glm::vec3 grow(0.0f);
+        grow[a] = radius;
+        if (rayEntersAABB(center, delta, b.min - grow, b.max + grow, t, axis) && t < best && axis == a) {
+            best = t;
+            normal = glm::vec3(0.0f);
+            normal[a] = delta[a] > 0.0f ? -1.0f : 1.0f;
+        }
+    }
+    // edges
+    for (int a = 0; a < 3; a++) {
+        int u = (a + 1) % 3, v = (a + 2) % 3;
+        for (int i = 0; i < 4; i++) {
+            float cu = (i & 1) ? b.max[u] : b.min[u];
+            float cv = (i & 2) ? b.max[v] : b.min[v];
+            if (rayEntersAxisCylinder(center, delta, a, cu, cv, b.min[a], b.max[a], radius, t, n) && t < best) {
+                best = t;
+                normal = n;
+            }
+        }
+    }
+    // corners
+    for (int i = 0; i < 8; i++) {
+        glm::vec3 c((i & 1) ? b.max.x : b.min.x, (i & 2) ? b.max.y : b.min.y, (i & 4) ? b.max.z : b.min.z);
+        if (rayEntersSphere(center, delta, c, radius, t) && t < best) {
+            best = t;
+            normal = (center + delta * t - c) / radius;
+        }
+    }
+    if (best > 1.0f) return false;
+    tHit = best;
+    return true;
+}
+
+// Moves a sphere by delta through boxes, stopping at the first contact and
+// sliding the rest of the move along the contact plane (up to maxIterations
+// contacts). For horizontal moves (delta.y == 0) normals are flattened to XZ,
+// which is exact for the horizontal slice the sphere travels in, so the sphere
+// never climbs over a box. Returns true if any contact happened.
+inline bool slideSphere(glm::vec3& center, float radius, glm::vec3 delta, const std::vector<const Box*>& boxes, int maxIterations = 4) {
+    const float skin = 1e-3f; // stop this far short of a contact so the next sweep starts outside
+    bool planar = (delta.y == 0.0f);
+    bool contact = false;
+    for (int iter = 0; iter < maxIterations; iter++) {
+        float len = glm::length(delta);
+        if (len < 1e-6f) break;
+
+        float tMin = 2.0f;
+        glm::vec3 nMin(0.0f);
+        const Box* hitBox = nullptr;
+        for (const Box* b : boxes) {
+            float t;
+            glm::vec3 n;
+            // ties go to the lowest address so the result doesn't depend on candidate order
+            if (sweepSphereAABB(center, radius, delta, *b, t, n) && (t < tMin || (t == tMin && b < hitBox))) {
+                tMin = t;
+                nMin = n;
+                hitBox = b;
+            }
+        }
+        if (tMin > 1.0f) {
+            center += delta;
+            break;
+        }
+
+        contact = true;
+        if (planar) {
+            nMin.y = 0.0f;
+            float nLen = glm::length(nMin);
+            if (nLen < 1e-6f) break; // pure vertical contact: nothing to slide along
+            nMin = nMin / nLen;
+        }
+        float travel = std::max(0.0f, tMin * len - skin);
+        center += delta * (travel / len);
+
+        glm::vec3 rest = delta * (1.0f - tMin);
+        delta = rest - nMin * glm::dot(rest, nMin);
+    }
+    return contact;
+}
+
+#endif
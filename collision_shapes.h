@@ -0,0 +1,259 @@
+#ifndef COLLISION_SHAPES_H
+#define COLLISION_SHAPES_H
+
+#include <glm/glm.hpp>
+
+#include "collision.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+// Collision shapes for characters and rotated props. Every shape pair has its
+// own overlap test picked at compile time by shapesOverlap<A, B>, so loops over
+// an array of one shape type carry no shape switch or virtual call.
+// Like sphereIntersectsAABB, touching does not count as overlapping.
+
+struct Sphere {
+    glm::vec3 center;
+    float radius;
+};
+
+// segment a-b swept by radius (standing character: a = feet, b = head)
+struct Capsule {
+    glm::vec3 a;
+    glm::vec3 b;
+    float radius;
+};
+
+// oriented box; axes columns are the (unit) local X/Y/Z directions
+struct OBB {
+    glm::vec3 center;
+    glm::vec3 halfExtents;
+    glm::mat3 axes;
+};
+
+// ---------- bounds for the broadphases ----------
+inline Box shapeBounds(const Sphere& s) {
+    return sphereBounds(s.center, s.radius);
+}
+
+inline Box shapeBounds(const Capsule& c) {
+    return { glm::min(c.a, c.b) - glm::vec3(c.radius), glm::max(c.a, c.b) + glm::vec3(c.radius) };
+}
+
+inline Box shapeBounds(const OBB& o) {
+    glm::vec3 e(0.0f);
+    for (int i = 0; i < 3; i++) e += glm::abs(o.axes[i]) * o.halfExtents[i];
+    return { o.center - e, o.center + e };
+}
+
+inline Box shapeBounds(const Box& b) {
+    return b;
+}
+
+// ---------- distance helpers ----------
+inline float pointBoxDistSq(const glm::vec3& p, const glm::vec3& bmin, const glm::vec3& bmax) {
+    glm::vec3 d = p - glm::clamp(p, bmin, bmax);
+    return glm::dot(d, d);
+}
+
+inline float pointSegmentDistSq(const glm::vec3& p, const glm::vec3& a, const glm::vec3& b) {
+    glm::vec3 ab = b - a;
+    float len2 = glm::dot(ab, ab);
+    float t = len2 > 0.0f ? glm::clamp(glm::dot(p - a, ab) / len2, 0.0f, 1.0f) : 0.0f;
+    glm::vec3 d = p - (a + ab * t);
+    return glm::dot(d, d);
+}
+
+// closest distance between segments p1-q1 and p2-q2 (Ericson, Real-Time Collision Detection 5.1.9)
+inline float segmentSegmentDistSq(const glm::vec3& p1, const glm::vec3& q1, const glm::vec3& p2, const glm::vec3& q2) {
+    const float eps = 1e-12f;
+    glm::vec3 d1 = q1 - p1, d2 = q2 - p2, r = p1 - p2;
+    float a = glm::dot(d1, d1), e = glm::dot(d2, d2), f = glm::dot(d2, r);
+    float s = 0.0f, t = 0.0f;
+    if (a <= eps && e <= eps) {
+        return glm::dot(r, r);
+    }
+    if (a <= eps) {
+        t = glm::clamp(f / e, 0.0f, 1.0f);
+    }
+    else {
+        float c = glm::dot(d1, r);
+        if (e <= eps) {
+            s = glm::clamp(-c / a, 0.0f, 1.0f);
+        }
+        else {
+            float b = glm::dot(d1, d2);
+            float denom = a * e - b * b;
+            s = denom > 0.0f ? glm::clamp((b * f - c * e) / denom, 0.0f, 1.0f) : 0.0f;
+            t = (b * s + f) / e;
+            if (t < 0.0f) {
+                t = 0.0f;
+                s = glm::clamp(-c / a, 0.0f, 1.0f);
+            }
+            else if (t > 1.0f) {
+                t = 1.0f;
+                s = glm::clamp((b - c) / a, 0.0f, 1.0f);
+            }
+        }
+    }
+    glm::vec3 d = (p1 + d1 * s) - (p2 + d2 * t);
+    return glm::dot(d, d);
+}
+
+// Distance from segment o + t*d (t in [0, 1]) to an AABB. Squared distance is a
+// convex piecewise quadratic in t with breaks where the segment crosses a slab
+// plane; each piece is minimized in closed form.
+inline float segmentBoxDistSq(const glm::vec3& o, const glm::vec3& d, const glm::vec3& bmin, const glm::vec3& bmax) {
+    float breaks[8];
+    int n = 0;
+    breaks[n++] = 0.0f;
+    for (int i = 0; i < 3; i++) {
+        if (d[i] == 0.0f) continue;
+        float t0 = (bmin[i] - o[i]) / d[i], t1 = (bmax[i] - o[i]) / d[i];
+        if (t0 > 0.0f && t0 < 1.0f) breaks[n++] = t0;
+        if (t1 > 0.0f && t1 < 1.0f) breaks[n++] = t1;
+    }
+    breaks[n++] = 1.0f;
+    for (int i = 1; i < n; i++) // at most 8 values
+        for (int j = i; j > 0 && breaks[j] < breaks[j - 1]; j--) std::swap(breaks[j], breaks[j - 1]);
+
+    float best = pointBoxDistSq(o, bmin, bmax);
+    for (int k = 0; k + 1 < n; k++) {
+        float lo = breaks[k], hi = breaks[k + 1];
+        glm::vec3 mid = o + d * (0.5f * (lo + hi));
+        // inside this piece each axis is either clamped to a face or inside the slab
+        float num = 0.0f, den = 0.0f;
+        for (int i = 0; i < 3; i++) {
+            float face;
+            if (mid[i] < bmin[i]) face = bmin[i];
+            else if (mid[i] > bmax[i]) face = bmax[i];
+            else continue;
+            num -= d[i] * (o[i] - face);
+            den += d[i] * d[i];
+        }
+        float t = den > 0.0f ? glm::clamp(num / den, lo, hi) : lo;
+        best = std::min(best, pointBoxDistSq(o + d * t, bmin, bmax));
+    }
+    return std::min(best, pointBoxDistSq(o + d, bmin, bmax));
+}
+
+// Separating axis test for two oriented boxes (15 axes). The small epsilon keeps
+// near-parallel edge pairs from producing a bogus separating axis.
+inline bool obbsOverlap(const glm::vec3& ca, const glm::vec3& ha, const glm::mat3& ua,
+                        const glm::vec3& cb, const glm::vec3& hb, const glm::mat3& ub) {
+    const float eps = 1e-6f;
+    float R[3][3], AbsR[3][3];
+    for (int i = 0; i < 3; i++)
+        for (int j = 0; j < 3; j++) {
+            R[i][j] = glm::dot(ua[i], ub[j]);
+            AbsR[i][j] = std::fabs(R[i][j]) + eps;
+        }
+    glm::vec3 tw = cb - ca;
+    float t[3] = { glm::dot(tw, ua[0]), glm::dot(tw, ua[1]), glm::dot(tw, ua[2]) };
+
+    for (int i = 0; i < 3; i++) {
+        float rb = hb[0] * AbsR[i][0] + hb[1] * AbsR[i][1] + hb[2] * AbsR[i][2];
+        if (std::fabs(t[i]) >= ha[i] + rb) return false;
+    }
+    for (int j = 0; j < 3; j++) {
+        float ra = ha[0] * AbsR[0][j] + ha[1] * AbsR[1][j] + ha[2] * AbsR[2][j];
+        if (std::fabs(t[0] * R[0][j] + t[1] * R[1][j] + t[2] * R[2][j]) >= ra + hb[j]) return false;
+    }
+    for (int i = 0; i < 3; i++) {
+        int i1 = (i + 1) % 3, i2 = (i + 2) % 3;
+        for (int j = 0; j < 3; j++) {
+            int j1 = (j + 1) % 3, j2 = (j + 2) % 3;
+            float ra = ha[i1] * AbsR[i2][j] + ha[i2] * AbsR[i1][j];
+            float rb = hb[j1] * AbsR[i][j2] + hb[j2] * AbsR[i][j1];
+            if (std::fabs(t[i2] * R[i1][j] - t[i1] * R[i2][j]) >= ra + rb) return false;
+        }
+    }
+    return true;
+}
+
+// point / segment into an OBB's local frame, where it is an AABB at the origin
+inline glm::vec3 toObbLocal(const OBB& o, const glm::vec3& p) {
+    glm::vec3 d = p - o.center;
+    return glm::vec3(glm::dot(d, o.axes[0]), glm::dot(d, o.axes[1]), glm::dot(d, o.axes[2]));
+}
+
+// ---------- compile-time pair dispatch ----------
+template <typename T> struct ShapeOrder;
+template <> struct ShapeOrder<Sphere> { static constexpr int value = 0; };
+template <> struct ShapeOrder<Capsule> { static constexpr int value = 1; };
+template <> struct ShapeOrder<OBB> { static constexpr int value = 2; };
+template <> struct ShapeOrder<Box> { static constexpr int value = 3; };
+
+template <typename T> struct DependentFalse : std::false_type {};
+
+// every pair is written once with A before B in ShapeOrder; the reverse pair swaps
+template <typename A, typename B>
+inline bool shapesOverlap(const A& a, const B& b) {
+    if constexpr (ShapeOrder<A>::value > ShapeOrder<B>::value) {
+        return shapesOverlap(b, a);
+    }
+    else if constexpr (std::is_same_v<A, Sphere> && std::is_same_v<B, Sphere>) {
+        glm::vec3 d = a.center - b.center;
+        float r = a.radius + b.radius;
+        return glm::dot(d, d) < r * r;
+    }
+    else if constexpr (std::is_same_v<A, Sphere> && std::is_same_v<B, Capsule>) {
+        float r = a.radius + b.radius;
+        return pointSegmentDistSq(a.center, b.a, b.b) < r * r;
+    }
+    else if constexpr (std::is_same_v<A, Sphere> && std::is_same_v<B, OBB>) {
+        return pointBoxDistSq(toObbLocal(b, a.center), -b.halfExtents, b.halfExtents) < a.radius * a.radius;
+    }
+    else if constexpr (std::is_same_v<A, Sphere> && std::is_same_v<B, Box>) {
+        return sphereIntersectsAABB(a.center, a.radius, b);
+    }
+    else if constexpr (std::is_same_v<A, Capsule> && std::is_same_v<B, Capsule>) {
+        float r = a.radius + b.radius;
+        return segmentSegmentDistSq(a.a, a.b, b.a, b.b) < r * r;
+    }
+    else if constexpr (std::is_same_v<A, Capsule> && std::is_same_v<B, OBB>) {
+        glm::vec3 p = toObbLocal(b, a.a);
+        return segmentBoxDistSq(p, toObbLocal(b, a.b) - p, -b.halfExtents, b.halfExtents) < a.radius * a.radius;
+    }
+    else if constexpr (std::is_same_v<A, Capsule> && std::is_same_v<B, Box>) {
+        return segmentBoxDistSq(a.a, a.b - a.a, b.min, b.max) < a.radius * a.radius;
+    }
+    else if constexpr (std::is_same_v<A, OBB> && std::is_same_v<B, OBB>) {
+        return obbsOverlap(a.center, a.halfExtents, a.axes, b.center, b.halfExtents, b.axes);
+    }
+    else if constexpr (std::is_same_v<A, OBB> && std::is_same_v<B, Box>) {
+        return obbsOverlap(a.center, a.halfExtents, a.axes, boxCenter(b), (b.max - b.min) * 0.5f, glm::mat3(1.0f));
+    }
+    else if constexpr (std::is_same_v<A, Box> && std::is_same_v<B, Box>) {
+        return a.min.x < b.max.x && a.max.x > b.min.x && a.min.y < b.max.y && a.max.y > b.min.y &&
+               a.min.z < b.max.z && a.max.z > b.min.z;
+    }
+    else {
+        static_assert(DependentFalse<A>::value, "no overlap test for this shape pair");
+        return false;
+    }
+}
+
+// ---------- batched over contiguous arrays ----------
+
+// does shape overlap any of boxes[0..count)
+template <typename Shape>
+inline bool overlapsAnyBox(const Shape& shape, const Box* boxes, size_t count) {
+    for (size_t i = 0; i < count; i++)
+        if (shapesOverlap(shape, boxes[i])) return true;
+    return false;
+}
+
+// same, over a list of box ids (broadphase candidates)
+template <typename Shape>
+inline bool overlapsAnyBox(const Shape& shape, const Box* boxes, const uint32_t* ids, size_t count) {
+    for (size_t i = 0; i < count; i++)
+        if (shapesOverlap(shape, boxes[ids[i]])) return true;
+    return false;
+}
+
+#endif
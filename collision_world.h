@@ -0,0 +1,437 @@
+#ifndef COLLISION_WORLD_H
+#define COLLISION_WORLD_H
+
+#include <glm/glm.hpp>
+
+#include "collision.h"
+#include "collision_shapes.h"
+#include "box_soa.h"
+#include "obstacle_bvh.h"
+#include "obstacle_grid.h"
+#include "platform_height_grid.h"
+#include "sweep_and_prune.h"
+#include "worker_pool.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <iostream>
+#include <type_traits>
+#include <vector>
+
+// BVH is built once after the level (static), the grid supports runtime insert/remove;
+// SweepAndPrune keeps agent-vs-obstacle pairs incrementally (agent moves only, other
+// queries go through the grid); BruteForce is kept as the reference path
+enum class Broadphase { BruteForce, BVH, Grid, SweepAndPrune };
+
+// Everything the character/NPC collision needs, over the level's obstacle and
+// platform vectors (owned by the caller). No GL; every query is const and
+// thread-safe as long as nobody mutates the world at the same time.
+class CollisionWorld {
+public:
+    std::vector<Box>& obstacles;
+    std::vector<Box>& platforms;
+    Broadphase broadphase = Broadphase::BVH;
+    bool verify = false; // run brute force alongside and report any mismatch
+
+    CollisionWorld(std::vector<Box>& obstacles, std::vector<Box>& platforms)
+        : obstacles(obstacles), platforms(platforms)
+    {
+    }
+
+    // build broadphases and the height index over the finished level
+    void rebuild()
+    {
+        rebuildObstacles();
+        rebuildPlatformIndex();
+    }
+
+    void rebuildObstacles()
+    {
+        bvh.build(obstacles);
+        grid.build(obstacles);
+        soa.assign(obstacles);
+        bvhDirty = false;
+        rebuildSweepAndPrune();
+    }
+
+    // platforms are baked, so call this whenever platforms changes
+    void rebuildPlatformIndex()
+    {
+        heights.build(platforms);
+    }
+
+    // runtime blockers: the grid is updated in place, the BVH is marked stale
+    unsigned int addObstacle(const Box& b)
+    {
+        unsigned int id = static_cast<unsigned int>(obstacles.size());
+        obstacles.push_back(b);
+        grid.insert(id, b);
+        soa.push(b);
+        obstacleProxies.push_back(sap.addProxy(b, false, id));
+        bvhDirty = true;
+        return id;
+    }
+
+    void moveObstacle(unsigned int id, const Box& b)
+    {
+        obstacles[id] = b;
+        grid.update(id, b);
+        soa.set(id, b);
+        sap.setBounds(obstacleProxies[id], b); // picked up by the next agent update
+        bvhDirty = true;
+    }
+
+    // swap-and-pop, so the last obstacle takes over id
+    void removeObstacle(unsigned int id)
+    {
+        unsigned int last = static_cast<unsigned int>(obstacles.size() - 1);
+        grid.remove(id);
+        if (id != last) {
+            grid.remove(last);
+            obstacles[id] = obstacles[last];
+            grid.insert(id, obstacles[id]);
+        }
+        obstacles.pop_back();
+        soa.removeSwap(id);
+        sap.removeProxy(obstacleProxies[id]);
+        if (id != last) {
+            obstacleProxies[id] = obstacleProxies[last];
+            sap.setUserData(obstacleProxies[id], id);
+        }
+        obstacleProxies.pop_back();
+        bvhDirty = true;
+    }
+
+    // rebuild a stale BVH; call once per tick before querying (queries fall back to
+    // the always-current grid while the BVH is stale)
+    void prepareQueries()
+    {
+        if (bvhDirty) {
+            bvh.build(obstacles);
+            bvhDirty = false;
+        }
+    }
+
+    // ids of obstacles whose AABB overlaps bounds, through the active broadphase
+    void gatherObstacleCandidates(const Box& bounds, std::vector<uint32_t>& out) const
+    {
+        out.clear();
+        switch (activeBroadphase()) {
+        case Broadphase::BVH:
+            bvh.query(bounds, out);
+            break;
+        case Broadphase::Grid:
+            grid.query(bounds, out);
+            break;
+        default:
+            for (uint32_t i = 0; i < obstacles.size(); i++)
+                if (boxesOverlap(bounds, obstacles[i])) out.push_back(i);
+            break;
+        }
+    }
+
+    // linear scan; spheres use the SIMD kernel, 8 (AVX2) / 4 (SSE) / 1 (scalar)
+    // boxes per step depending on CPUID
+    template <typename Shape>
+    bool collidesWithAnyObstacleBruteForce(const Shape& shape) const
+    {
+        if constexpr (std::is_same_v<Shape, Sphere>)
+            return sphereOverlapsAny(soa, 0, soa.size(), shape.center, shape.radius);
+        else
+            return overlapsAnyBox(shape, obstacles.data(), obstacles.size());
+    }
+
+    // Shape is Sphere, Capsule, OBB or Box; the narrowphase is picked at compile
+    // time. Spheres keep the SIMD leaf/cell kernels, other shapes gather
+    // candidates from the broadphase and test them with shapesOverlap.
+    template <typename Shape>
+    bool collidesWithAnyObstacle(const Shape& shape) const
+    {
+        Broadphase mode = activeBroadphase();
+        if (mode == Broadphase::BruteForce)
+            return collidesWithAnyObstacleBruteForce(shape);
+
+        bool hit;
+        if constexpr (std::is_same_v<Shape, Sphere>) {
+            hit = (mode == Broadphase::Grid) ? grid.anyOverlap(shape.center, shape.radius)
+                                             : bvh.anyOverlap(shape.center, shape.radius);
+        }
+        else {
+            static thread_local std::vector<uint32_t> candidates;
+            gatherObstacleCandidates(shapeBounds(shape), candidates);
+            hit = overlapsAnyBox(shape, obstacles.data(), candidates.data(), candidates.size());
+        }
+        if (verify && hit != collidesWithAnyObstacleBruteForce(shape)) {
+            glm::vec3 c = boxCenter(shapeBounds(shape));
+            std::cerr << "Broadphase mismatch at (" << c.x << ", " << c.y << ", " << c.z
+                      << "): mode=" << static_cast<int>(mode) << " hit=" << hit << std::endl;
+        }
+        return hit;
+    }
+
+    bool collidesWithAnyObstacleBruteForce(const glm::vec3& center, float radius) const
+    {
+        return collidesWithAnyObstacleBruteForce(Sphere{ center, radius });
+    }
+
+    bool collidesWithAnyObstacle(const glm::vec3& center, float radius) const
+    {
+        return collidesWithAnyObstacle(Sphere{ center, radius });
+    }
+
+    // reference linear scan, also used to verify the height grid
+    bool highestPlatformTopAtXZBruteForce(float x, float z, float& outTopY) const
+    {
+        bool found = false;
+        float best = -1e9f;
+        for (auto& p : platforms) {
+            if (x >= p.min.x && x <= p.max.x && z >= p.min.z && z <= p.max.z) {
+                if (p.max.y > best) {
+                    best = p.max.y;
+                    found = true;
+                }
+            }
+        }
+        if (found) outTopY = best;
+        return found;
+    }
+
+    // find highest platform top under XZ
+    bool highestPlatformTopAtXZ(float x, float z, float& outTopY) const
+    {
+        if (broadphase == Broadphase::BruteForce)
+            return highestPlatformTopAtXZBruteForce(x, z, outTopY);
+
+        bool found = heights.highestTopAt(x, z, outTopY);
+        if (verify) {
+            float refY = 0.0f;
+            bool refFound = highestPlatformTopAtXZBruteForce(x, z, refY);
+            if (refFound != found || (found && refY != outTopY)) {
+                std::cerr << "Height grid mismatch at (" << x << ", " << z << ")" << std::endl;
+            }
+        }
+        return found;
+    }
+
+    // Sweep a sphere along move, sliding along whatever it hits, then snap it to the
+    // highest platform under it. Sliding never lengthens the move, so one broadphase
+    // query around it is enough. Returns true if the sphere touched an obstacle.
+    bool moveSphere(glm::vec3& center, float radius, const glm::vec3& move) const
+    {
+        // per-thread scratch so batch workers don't allocate per agent
+        static thread_local std::vector<uint32_t> candidates;
+        gatherObstacleCandidates(sphereBounds(center, radius + glm::length(move)), candidates);
+        return slideAndSnap(center, radius, move, candidates.data(), candidates.size());
+    }
+
+    // ---------- batch queries for many agents ----------
+    // Agents are split across pool (or run inline without one) in contiguous chunks,
+    // each reusing the same single-sphere paths as the player.
+
+    // outHit[i] = does sphere i overlap any obstacle
+    void collidesBatch(const glm::vec3* centers, const float* radii, size_t count, uint8_t* outHit,
+                       WorkerPool* pool = nullptr)
+    {
+        prepareQueries();
+        auto run = [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; i++)
+                outHit[i] = collidesWithAnyObstacle(centers[i], radii[i]) ? 1 : 0;
+        };
+        if (pool) pool->parallelFor(count, BATCH_GRAIN, run);
+        else run(0, count);
+    }
+
+    // outPositions[i] = centers[i] moved by moves[i] with slide + ground snap,
+    // outCollided[i] = whether that move touched an obstacle
+    void moveSpheresBatch(const glm::vec3* centers, const float* radii, const glm::vec3* moves, size_t count,
+                          glm::vec3* outPositions, uint8_t* outCollided, WorkerPool* pool = nullptr)
+    {
+        prepareQueries();
+        auto run = [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; i++) {
+                glm::vec3 p = centers[i];
+                bool contact = moveSphere(p, radii[i], moves[i]);
+                outPositions[i] = p;
+                outCollided[i] = contact ? 1 : 0;
+            }
+        };
+        if (pool) pool->parallelFor(count, BATCH_GRAIN, run);
+        else run(0, count);
+    }
+
+    // ---------- sweep and prune agents ----------
+    // Agents (player, NPCs) are moving proxies in the sweep-and-prune broadphase.
+    // Each tick their swept bounds are set, the endpoint lists are re-sorted once,
+    // and each agent's obstacle candidates are read off the pair list.
+
+    uint32_t addAgent(const glm::vec3& center, float radius)
+    {
+        uint32_t agent;
+        if (!freeAgents.empty()) {
+            agent = freeAgents.back();
+            freeAgents.pop_back();
+        }
+        else {
+            agent = static_cast<uint32_t>(agentProxies.size());
+            agentProxies.push_back(NO_PROXY);
+        }
+        agentProxies[agent] = sap.addProxy(sphereBounds(center, radius), true, AGENT_BIT | agent);
+        return agent;
+    }
+
+    void removeAgent(uint32_t agent)
+    {
+        sap.removeProxy(agentProxies[agent]);
+        agentProxies[agent] = NO_PROXY;
+        freeAgents.push_back(agent);
+    }
+
+    // moveSphere for a registered agent; outside SweepAndPrune mode this is just moveSphere
+    bool moveAgent(uint32_t agent, glm::vec3& center, float radius, const glm::vec3& move)
+    {
+        if (broadphase != Broadphase::SweepAndPrune) return moveSphere(center, radius, move);
+        uint8_t contact = 0;
+        moveAgentsBatch(&agent, &center, &radius, &move, 1, &center, &contact);
+        return contact != 0;
+    }
+
+    // batch version: one endpoint update for all agents, then the slides run on pool
+    // (outPositions may alias centers)
+    void moveAgentsBatch(const uint32_t* agents, const glm::vec3* centers, const float* radii, const glm::vec3* moves,
+                         size_t count, glm::vec3* outPositions, uint8_t* outCollided, WorkerPool* pool = nullptr)
+    {
+        if (broadphase != Broadphase::SweepAndPrune) {
+            moveSpheresBatch(centers, radii, moves, count, outPositions, outCollided, pool);
+            return;
+        }
+
+        prepareQueries();
+        for (size_t i = 0; i < count; i++)
+            sap.setBounds(agentProxies[agents[i]], sphereBounds(centers[i], radii[i] + glm::length(moves[i])));
+        sap.update();
+        gatherAgentCandidates(agents, count);
+
+        auto run = [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; i++) {
+                glm::vec3 p = centers[i];
+                uint32_t first = agentCandidateStart[i];
+                bool contact = slideAndSnap(p, radii[i], moves[i], agentCandidates.data() + first,
+                                            agentCandidateStart[i + 1] - first);
+                outPositions[i] = p;
+                outCollided[i] = contact ? 1 : 0;
+            }
+        };
+        if (pool) pool->parallelFor(count, BATCH_GRAIN, run);
+        else run(0, count);
+    }
+
+    const SweepAndPrune& getSweepAndPrune() const { return sap; }
+    const ObstacleBVH& getBVH() const { return bvh; }
+    const ObstacleGrid& getGrid() const { return grid; }
+    const PlatformHeightGrid& getHeights() const { return heights; }
+
+private:
+    static const size_t BATCH_GRAIN = 256; // agents per chunk handed to a worker
+    static constexpr uint32_t AGENT_BIT = 0x80000000u; // sap userData: agent index instead of obstacle id
+    static constexpr uint32_t NO_PROXY = 0xffffffffu;
+
+    ObstacleBVH bvh;
+    ObstacleGrid grid;
+    BoxSoA soa; // SoA mirror of obstacles for the SIMD brute-force scan
+    PlatformHeightGrid heights;
+    bool bvhDirty = false;
+
+    SweepAndPrune sap; // X/Z endpoints of every obstacle and agent
+    std::vector<uint32_t> obstacleProxies; // obstacle id -> sap proxy
+    std::vector<uint32_t> agentProxies;    // agent -> sap proxy
+    std::vector<uint32_t> freeAgents;
+    std::vector<uint32_t> agentCandidateStart; // CSR of obstacle ids per batch entry
+    std::vector<uint32_t> agentCandidates;
+    std::vector<uint32_t> agentEntry; // agent -> index in the current batch
+    std::vector<std::pair<uint32_t, uint32_t>> agentPairs; // (batch index, obstacle id)
+
+    // the pair list only makes sense for registered agents, so region queries
+    // in SweepAndPrune mode use the grid; a stale BVH also falls back to it
+    Broadphase activeBroadphase() const
+    {
+        if (broadphase == Broadphase::BVH && bvhDirty) return Broadphase::Grid;
+        if (broadphase == Broadphase::SweepAndPrune) return Broadphase::Grid;
+        return broadphase;
+    }
+
+    bool slideAndSnap(glm::vec3& center, float radius, const glm::vec3& move, const uint32_t* ids, size_t idCount) const
+    {
+        static thread_local std::vector<const Box*> candidateBoxes;
+        candidateBoxes.clear();
+        for (size_t i = 0; i < idCount; i++) candidateBoxes.push_back(&obstacles[ids[i]]);
+        bool contact = slideSphere(center, radius, move, candidateBoxes);
+
+        float topY = 0.0f;
+        if (highestPlatformTopAtXZ(center.x, center.z, topY)) {
+            center.y = topY;
+        }
+        return contact;
+    }
+
+    // bucket the agent-obstacle pairs by batch entry; the pair list only tests X/Z,
+    // so Y is checked here to give the same candidates as the other broadphases
+    void gatherAgentCandidates(const uint32_t* agents, size_t count)
+    {
+        static const uint32_t NOT_IN_BATCH = 0xffffffffu;
+        agentEntry.assign(agentProxies.size(), NOT_IN_BATCH);
+        for (size_t i = 0; i < count; i++) agentEntry[agents[i]] = static_cast<uint32_t>(i);
+
+        agentPairs.clear();
+        for (const auto& pr : sap.pairs()) {
+            uint32_t a = sap.getUserData(pr.first), b = sap.getUserData(pr.second);
+            if ((a & AGENT_BIT) == (b & AGENT_BIT)) continue; // agent-agent
+            uint32_t agent = ((a & AGENT_BIT) ? a : b) & ~AGENT_BIT;
+            uint32_t proxy = (a & AGENT_BIT) ? pr.first : pr.second;
+            uint32_t id = (a & AGENT_BIT) ? b : a;
+            uint32_t entry = agentEntry[agent];
+            if (entry == NOT_IN_BATCH || !boxesOverlap(sap.getBounds(proxy), obstacles[id])) continue;
+            agentPairs.push_back({ entry, id });
+        }
+        std::sort(agentPairs.begin(), agentPairs.end());
+
+        agentCandidateStart.assign(count + 1, 0);
+        agentCandidates.clear();
+        for (const auto& f : agentPairs) {
+            agentCandidateStart[f.first + 1]++;
+            agentCandidates.push_back(f.second);
+        }
+        for (size_t i = 0; i < count; i++) agentCandidateStart[i + 1] += agentCandidateStart[i];
+
+        if (verify) {
+            std::vector<uint32_t> ref;
+            for (size_t i = 0; i < count; i++) {
+                ref.clear();
+                for (uint32_t id = 0; id < obstacles.size(); id++)
+                    if (boxesOverlap(sap.getBounds(agentProxies[agents[i]]), obstacles[id])) ref.push_back(id);
+                if (ref.size() != agentCandidateStart[i + 1] - agentCandidateStart[i]) {
+                    std::cerr << "Sweep and prune mismatch for agent " << agents[i] << ": " << ref.size() << " expected, "
+                              << agentCandidateStart[i + 1] - agentCandidateStart[i] << " found" << std::endl;
+                }
+            }
+        }
+    }
+
+    // fresh endpoint lists for the whole obstacle set, keeping the registered agents
+    void rebuildSweepAndPrune()
+    {
+        std::vector<Box> agentBounds(agentProxies.size());
+        for (size_t a = 0; a < agentProxies.size(); a++)
+            if (agentProxies[a] != NO_PROXY) agentBounds[a] = sap.getBounds(agentProxies[a]);
+
+        sap = SweepAndPrune();
+        sap.beginBulkLoad();
+        obstacleProxies.resize(obstacles.size());
+        for (uint32_t id = 0; id < obstacles.size(); id++)
+            obstacleProxies[id] = sap.addProxy(obstacles[id], false, id);
+        for (uint32_t a = 0; a < agentProxies.size(); a++)
+            if (agentProxies[a] != NO_PROXY) agentProxies[a] = sap.addProxy(agentBounds[a], true, AGENT_BIT | a);
+        sap.endBulkLoad();
+    }
+};
+
+#endif
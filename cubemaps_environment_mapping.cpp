@@ -11,10 +11,30 @@
 #include <learnopengl/camera.h>
 #include <learnopengl/model.h>
 
+#include "collision_world.h"
+#include "box_coalesce.h"
+#include "static_maze_mesh.h"
+#include "frustum_culling.h"
+#include "maze_pvs.h"
+#include "occlusion_culler.h"
+#include "indirect_draw.h"
+#include "model_cache.h"
+#include "packed_model.h"
+#include "render_queue.h"
+#include "frame_uniforms.h"
+#include "headless_context.h"
+#include "input_script.h"
+#include "gpu_timer.h"
+#include "asset_loader.h"
+
 #include <iostream>
 #include <vector>
 #include <algorithm>
 #include <string>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <chrono>
 
 using namespace std;
 
@@ -47,69 +67,6 @@ static GLuint compileShaderProgram(const char* vsSource, const char* fsSource) {
     return prog;
 }
 
-// ---------- basic texture loader ----------
-unsigned int loadTexture(const std::string& path)
-{
-    int width, height, nrComponents;
-    unsigned char* data = stbi_load(path.c_str(), &width, &height, &nrComponents, 0);
-    if (!data) {
-        std::cerr << "Failed to load texture: " << path << std::endl;
-        return 0;
-    }
-
-    GLenum format = GL_RGB;
-    if (nrComponents == 1) format = GL_RED;
-    else if (nrComponents == 3) format = GL_RGB;
-    else if (nrComponents == 4) format = GL_RGBA;
-
-    unsigned int tex;
-    glGenTextures(1, &tex);
-    glBindTexture(GL_TEXTURE_2D, tex);
-    glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, data);
-    glGenerateMipmap(GL_TEXTURE_2D);
-
-    // reasonable parameters for repeating tiled walls
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
-    stbi_image_free(data);
-    return tex;
-}
-
-// ---------- cubemap loader (unchanged) ----------
-unsigned int loadCubemap(vector<string> faces)
-{
-    unsigned int textureID;
-    glGenTextures(1, &textureID);
-    glBindTexture(GL_TEXTURE_CUBE_MAP, textureID);
-
-    int width, height, nrComponents;
-    for (unsigned int i = 0; i < faces.size(); i++)
-    {
-        unsigned char* data = stbi_load(faces[i].c_str(), &width, &height, &nrComponents, 0);
-        if (data)
-        {
-            // assume RGB images for skybox
-            glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, GL_RGB, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, data);
-            stbi_image_free(data);
-        }
-        else
-        {
-            std::cout << "Cubemap texture failed to load at path: " << faces[i] << std::endl;
-            stbi_image_free(data);
-        }
-    }
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
-
-    return textureID;
-}
-
 // callbacks
 void framebuffer_size_callback(GLFWwindow* window, int width, int height);
 void mouse_callback(GLFWwindow* window, double xpos, double ypos);
@@ -140,6 +97,7 @@ float lastFrame = 0.0f;
 glm::vec3 objectPos(-17.0f, 0.0f, -17.0f); // starting position (open spot)
 float objectSpeed = 4.0f;
 float objectRadius = 0.5f; // used for collision (sphere radius)
+uint32_t playerAgent = 0;  // player's proxy in the sweep-and-prune broadphase
 
 // simple cube for platform/obstacle (positions only)
 float cubeVertices[] = {
@@ -232,72 +190,237 @@ float skyboxVertices[] = {
      1.0f, -1.0f,  1.0f
 };
 
-// Simple Box struct (AABB)
-struct Box {
-    glm::vec3 min;
-    glm::vec3 max;
-};
-
 // ---------- multiple platforms & obstacles ----------
 vector<Box> platforms;   // ground + elevated
 vector<Box> obstacles;   // maze walls and blockers
 
-// sphere vs AABB collision test
-bool sphereIntersectsAABB(const glm::vec3& center, float radius, const Box& b) {
-    float x = std::max(b.min.x, std::min(center.x, b.max.x));
-    float y = std::max(b.min.y, std::min(center.y, b.max.y));
-    float z = std::max(b.min.z, std::min(center.z, b.max.z));
-    float distSq = (x - center.x) * (x - center.x) + (y - center.y) * (y - center.y) + (z - center.z) * (z - center.z);
-    return distSq < (radius * radius);
-}
+// ---------- collision ----------
+// broadphases + height index over obstacles/platforms, rebuilt after the maze is built
+CollisionWorld collisionWorld(obstacles, platforms);
 
 bool collidesWithAnyObstacle(const glm::vec3& center, float radius) {
-    for (auto& b : obstacles) {
-        if (sphereIntersectsAABB(center, radius, b)) return true;
-    }
-    return false;
+    return collisionWorld.collidesWithAnyObstacle(Sphere{ center, radius });
 }
 
 // find highest platform top under XZ
 bool highestPlatformTopAtXZ(float x, float z, float& outTopY) {
-    bool found = false;
-    float best = -1e9f;
-    for (auto& p : platforms) {
-        if (x >= p.min.x && x <= p.max.x && z >= p.min.z && z <= p.max.z) {
-            if (p.max.y > best) {
-                best = p.max.y;
-                found = true;
+    return collisionWorld.highestPlatformTopAtXZ(x, z, outTopY);
+}
+
+// ---------- instanced walls ----------
+// one instance per platform/obstacle box: the wall shader scales the unit cube
+// to the box size and moves it to the box center, so all boxes draw in one call
+struct WallInstance {
+    glm::vec3 center;
+    glm::vec3 size;
+    glm::vec3 tint;
+};
+
+// maze box i as drawn: platforms first, then obstacles (same order as the baked mesh)
+static const Box& mazeBox(uint32_t i) {
+    return i < platforms.size() ? platforms[i] : obstacles[i - platforms.size()];
+}
+
+// fill the instance buffer with the given maze boxes (all of them, or the visible ones)
+static GLsizei uploadWallInstances(GLuint instanceVBO, const vector<uint32_t>& boxes) {
+    vector<WallInstance> instances;
+    instances.reserve(boxes.size());
+    for (uint32_t i : boxes) {
+        const Box& b = mazeBox(i);
+        // near-white tint for floor, neutral tint (texture shows) for walls
+        glm::vec3 tint(i < platforms.size() ? 0.9f : 1.0f);
+        instances.push_back({ (b.min + b.max) * 0.5f, b.max - b.min, tint });
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, instanceVBO);
+    glBufferData(GL_ARRAY_BUFFER, instances.size() * sizeof(WallInstance), instances.data(), GL_DYNAMIC_DRAW);
+    return static_cast<GLsizei>(instances.size());
+}
+
+// wall draw path: baked world-space mesh (B) or instanced unit cubes (I)
+bool drawBakedMaze = true;
+
+// ---------- frustum culling ----------
+bool frustumCullingEnabled = true; // C toggles, to compare against drawing everything
+
+// precomputed visible sets per maze cell; P toggles. Used while the camera is in
+// a cell that has a set, the frustum test then only runs over that set
+bool pvsEnabled = true;
+
+// software occlusion culling after the PVS / frustum step; O toggles
+bool occlusionCullingEnabled = true;
+const size_t MAX_OCCLUDERS = 32; // walls rasterized into the depth buffer per frame
+
+// ---------- asset streaming ----------
+// GL upload time the background loader may use per frame
+const double ASSET_UPLOAD_BUDGET_MS = 2.0;
+
+// ---------- model LOD ----------
+// every model mesh draws the coarsest cooked level of detail whose error stays
+// under LOD_PIXEL_ERROR pixels on screen; L toggles (off = full detail)
+bool lodEnabled = true;
+const float LOD_PIXEL_ERROR = 1.0f;
+
+// ---------- indirect draws ----------
+// maze and model submitted with glMultiDraw*Indirect when the context has it; M toggles
+bool useIndirectDraws = true;
+
+// ---------- headless runs ----------
+// --headless renders into an offscreen framebuffer without a window; keys and
+// mouse then come from an input script instead of GLFW
+struct RunOptions {
+    bool headless = false;
+    int width = SCR_WIDTH, height = SCR_HEIGHT;
+    int frames = -1;               // headless frame count (default: the script's length, or 600)
+    float timeStep = 1.0f / 60.0f; // headless simulation step, frames don't depend on render speed
+    string scriptPath;
+    string capturePath;            // PPM of the last frame
+    string timingsPath;            // per-pass timings log, CSV or .json
+    string modelPath;              // another OBJ instead of the winter girl
+    bool compactVertices = false;  // 16-byte quantized model vertices
+
+    // build statistics go to the console only in measuring runs
+    bool diagnostics() const { return headless || !timingsPath.empty(); }
+};
+
+InputScript inputScript;
+bool scriptedInput = false;
+int scriptFrame = 0;
+bool headlessQuit = false; // ESC in the script
+
+static bool keyDown(GLFWwindow* window, int key) {
+    if (scriptedInput) return inputScript.keyDown(scriptFrame, key);
+    return glfwGetKey(window, key) == GLFW_PRESS;
+}
+
+static double seconds() {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static bool parseOptions(int argc, char** argv, RunOptions& options) {
+    for (int i = 1; i < argc; i++) {
+        string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--headless") options.headless = true;
+        else if (arg == "--size" && hasValue) {
+            if (sscanf(argv[++i], "%dx%d", &options.width, &options.height) != 2 || options.width <= 0 || options.height <= 0) {
+                std::cerr << "--size expects WIDTHxHEIGHT\n";
+                return false;
             }
         }
+        else if (arg == "--frames" && hasValue) options.frames = atoi(argv[++i]);
+        else if (arg == "--dt" && hasValue) options.timeStep = static_cast<float>(atof(argv[++i]));
+        else if (arg == "--script" && hasValue) options.scriptPath = argv[++i];
+        else if (arg == "--capture" && hasValue) options.capturePath = argv[++i];
+        else if (arg == "--timings" && hasValue) options.timingsPath = argv[++i];
+        else if (arg == "--model" && hasValue) options.modelPath = argv[++i];
+        else if (arg == "--compact-vertices") options.compactVertices = true;
+        else {
+            std::cerr << "usage: " << argv[0] << " [--headless [--size WxH] [--frames N] [--dt SECONDS] [--script FILE] [--capture FILE.ppm]]"
+                      << " [--timings FILE.csv|FILE.json] [--model FILE.obj] [--compact-vertices]\n";
+            return false;
+        }
     }
-    if (found) outTopY = best;
-    return found;
+    return true;
+}
+
+struct CullStats {
+    size_t visibleBoxes = 0;
+    size_t culledBoxes = 0;
+    bool modelVisible = true;
+    bool pvsUsed = false;
+    size_t pvsBoxes = 0; // size of the camera cell's set
+    size_t occludedBoxes = 0;
+};
+
+// "cull -/0.40 model 0.20/0.05 ..." : smoothed GPU / CPU ms per pass ("-" for CPU-only passes)
+static string formatPassTimings(const PassTimer& timer) {
+    string text;
+    char buf[64];
+    for (const PassTimer::Timing& t : timer.results()) {
+        if (t.gpu) snprintf(buf, sizeof(buf), "%s%s %.2f/%.2f", text.empty() ? "" : " ", t.name.c_str(), t.gpuAverage, t.cpuAverage);
+        else snprintf(buf, sizeof(buf), "%s%s -/%.2f", text.empty() ? "" : " ", t.name.c_str(), t.cpuAverage);
+        text += buf;
+    }
+    return text;
+}
+
+// sorted maze box indices (see mazeBox) inside the frustum: the few platforms go
+// through the SIMD kernel directly, the obstacles through the collision BVH
+static void cullMazeBoxes(const Frustum& frustum, const BoxSoA& platformSoa, vector<uint32_t>& visible) {
+    visible.clear();
+    static vector<uint8_t> flags;
+    flags.resize(platforms.size());
+    frustumCullBoxes(platformSoa, 0, platforms.size(), frustum, flags.data());
+    for (uint32_t i = 0; i < platforms.size(); i++)
+        if (flags[i]) visible.push_back(i);
+
+    size_t firstObstacle = visible.size();
+    collisionWorld.getBVH().frustumQuery(frustum, visible);
+    for (size_t i = firstObstacle; i < visible.size(); i++) visible[i] += static_cast<uint32_t>(platforms.size());
+    std::sort(visible.begin() + firstObstacle, visible.end());
 }
 
 // ------------------------- MAIN -------------------------
-int main()
+int main(int argc, char** argv)
 {
-    // glfw init
-    glfwInit();
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
-    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+    double launchTime = seconds();
+    RunOptions options;
+    if (!parseOptions(argc, argv, options)) return -1;
+    if (!options.scriptPath.empty()) {
+        if (!inputScript.load(options.scriptPath)) return -1;
+        scriptedInput = true;
+    }
+
+    GLFWwindow* window = nullptr;
+    HeadlessContext headlessContext;
+    OffscreenTarget offscreen;
+    GLADloadproc getProc = (GLADloadproc)glfwGetProcAddress;
+    if (options.headless) {
+        if (!headlessContext.create(options.width, options.height)) return -1;
+        getProc = (GLADloadproc)HeadlessContext::getProcAddress;
+        if (options.frames < 0) options.frames = scriptedInput && inputScript.frameCount() > 0 ? inputScript.frameCount() : 600;
+        scriptedInput = true; // no script: an empty one, nothing pressed
+    }
+    else {
+        // glfw init
+        glfwInit();
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+        glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
 #ifdef __APPLE__
-    glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
+        glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
 #endif
 
-    GLFWwindow* window = glfwCreateWindow(SCR_WIDTH, SCR_HEIGHT, "3rd-Person Movement & Maze (textured walls)", NULL, NULL);
-    if (!window) { std::cout << "Failed to create GLFW window\n"; glfwTerminate(); return -1; }
-    glfwMakeContextCurrent(window);
+        window = glfwCreateWindow(options.width, options.height, "3rd-Person Movement & Maze (textured walls)", NULL, NULL);
+        if (!window) { std::cout << "Failed to create GLFW window\n"; glfwTerminate(); return -1; }
+        glfwMakeContextCurrent(window);
 
-    glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
-    glfwSetCursorPosCallback(window, mouse_callback);
-    glfwSetScrollCallback(window, scroll_callback);
-    glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
+        glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
+        if (!scriptedInput) {
+            // with a script the cursor and wheel are the script's alone
+            glfwSetCursorPosCallback(window, mouse_callback);
+            glfwSetScrollCallback(window, scroll_callback);
+        }
+        glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
+    }
 
-    if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress)) { std::cout << "Failed to init GLAD\n"; return -1; }
+    if (!gladLoadGLLoader(getProc)) { std::cout << "Failed to init GLAD\n"; return -1; }
+    if (options.headless) {
+        if (!offscreen.create(options.width, options.height)) return -1;
+        offscreen.bind(); // stays bound, every pass draws into it
+        std::cout << "Headless: " << headlessContext.backendName() << ", " << options.width << "x" << options.height << ", "
+                  << options.frames << " frames, renderer " << (const char*)glGetString(GL_RENDERER) << std::endl;
+    }
     glEnable(GL_DEPTH_TEST);
 
+    // multi-draw-indirect isn't in the 3.3 glad loader, fetch it if the driver has it
+    IndirectDrawApi indirectApi;
+    indirectApi.load(getProc);
+    if (options.diagnostics())
+        std::cout << "GL " << indirectApi.major << "." << indirectApi.minor << ", multi-draw-indirect "
+                  << (indirectApi.available() ? "on" : "off") << ", persistent mapping "
+                  << (indirectApi.persistent() ? "on" : "off") << std::endl;
+
     // shaders
     Shader modelShader("6.2.cubemaps.vs", "6.2.cubemaps.fs"); // used for model & textured things
     Shader skyboxShader("6.2.skybox.vs", "6.2.skybox.fs");   // skybox
@@ -306,39 +429,92 @@ int main()
     const char* wallVs = R"(
         #version 330 core
         layout(location = 0) in vec3 aPos;
-        uniform mat4 model;
-        uniform mat4 view;
-        uniform mat4 projection;
+        layout(location = 1) in vec3 iCenter; // per instance: box center
+        layout(location = 2) in vec3 iSize;   // per instance: box size
+        layout(location = 3) in vec3 iTint;   // per instance: tint
+        layout(std140) uniform FrameData {
+            mat4 view;
+            mat4 projection;
+            mat4 viewProj;
+            mat4 skyView;
+            vec4 cameraPos;
+        };
         uniform float uvScale;
         out vec2 TexCoord;
+        out vec3 Tint;
         void main() {
-            vec4 world = model * vec4(aPos, 1.0);
+            vec4 world = vec4(aPos * iSize + iCenter, 1.0);
             // tile using world XZ, uvScale controls tiling density
             TexCoord = fract(world.xz * uvScale);
-            gl_Position = projection * view * world;
+            Tint = iTint;
+            gl_Position = viewProj * world;
         }
     )";
     const char* wallFs = R"(
         #version 330 core
         out vec4 FragColor;
         in vec2 TexCoord;
+        in vec3 Tint;
         uniform sampler2D wallTex;
-        uniform vec3 tint;
         void main() {
             vec3 tex = texture(wallTex, TexCoord).rgb;
-            FragColor = vec4(tex * tint, 1.0);
+            FragColor = vec4(tex * Tint, 1.0);
         }
     )";
     GLuint wallProg = compileShaderProgram(wallVs, wallFs);
-    GLint wall_uModel = glGetUniformLocation(wallProg, "model");
-    GLint wall_uView = glGetUniformLocation(wallProg, "view");
-    GLint wall_uProj = glGetUniformLocation(wallProg, "projection");
     GLint wall_uUVScale = glGetUniformLocation(wallProg, "uvScale");
-    GLint wall_uTint = glGetUniformLocation(wallProg, "tint");
     GLint wall_uTex = glGetUniformLocation(wallProg, "wallTex");
 
-    // model
-    Model ourModel(FileSystem::getPath("resources/objects/winter-girl/Winter_Girl.obj"));
+    // camera matrices come from the shared FrameData block, the rest never changes
+    bindFrameUniforms(modelShader.ID);
+    bindFrameUniforms(skyboxShader.ID);
+    bindFrameUniforms(wallProg);
+    glUseProgram(wallProg);
+    glUniform1i(wall_uTex, 0); // wall texture on unit 0
+    // tile scale (how many texture repeats per world unit) - tweak to taste
+    float uvScale = 0.25f; // lower = larger tiles, higher = more repeats
+    glUniform1f(wall_uUVScale, uvScale);
+
+    // assets load in the background: files are read and decoded on the loader's
+    // threads while the first frames draw placeholders, and the GL uploads are
+    // spread over frames, ASSET_UPLOAD_BUDGET_MS at a time
+    AssetLoader assetLoader;
+    double assetStart = seconds();
+
+    // model: from the cooked cache next to the OBJ, or through Assimp (cooking the
+    // cache for next time, meshes reordered for the vertex cache and overdraw)
+    // when it's missing or the OBJ changed
+    PackedModel packedModel;
+    bool modelArrived = false; // resident since last frame, the loop picks it up
+    string modelPath = options.modelPath.empty() ? FileSystem::getPath("resources/objects/winter-girl/Winter_Girl.obj")
+                                                 : options.modelPath;
+    VertexFormat modelFormat = options.compactVertices ? VertexFormat::Compact : VertexFormat::Full;
+    loadPackedModelAsync(assetLoader, packedModel, modelPath, modelFormat, [&](const CookedModel& cooked, bool fromCache) {
+        if (options.diagnostics()) {
+            // triangles per LOD level; a mesh with a shorter chain counts its coarsest level
+            vector<size_t> lodTriangles;
+            for (size_t i = 0; i < cooked.meshCount(); i++) {
+                const CookedMesh& mesh = cooked.mesh(i);
+                lodTriangles.resize(std::max<size_t>(lodTriangles.size(), std::max<uint32_t>(mesh.lodCount, 1)), 0);
+                for (size_t l = 0; l < lodTriangles.size(); l++) {
+                    if (!mesh.lodCount) lodTriangles[l] += mesh.indexCount / 3;
+                    else lodTriangles[l] += cooked.lod(mesh.firstLod + std::min<size_t>(l, mesh.lodCount - 1)).indexCount / 3;
+                }
+            }
+            std::cout << "Model: " << cooked.meshCount() << " meshes, " << (lodTriangles.empty() ? 0 : lodTriangles[0])
+                      << " triangles from " << (fromCache ? "cache" : "OBJ") << ", resident after "
+                      << (seconds() - assetStart) * 1000.0 << " ms" << std::endl;
+            std::cout << "Model LOD triangles:";
+            for (size_t t : lodTriangles) std::cout << " " << t;
+            std::cout << std::endl;
+            std::cout << "Model vertices: " << cooked.vertexCount() << " x "
+                      << (packedModel.vertexFormat() == VertexFormat::Compact ? sizeof(CompactVertex) : sizeof(Vertex))
+                      << " bytes = " << packedModel.vertexBufferBytes() / 1024 << " KiB" << std::endl;
+            std::cout << "Model vertex cache (FIFO " << VERTEX_CACHE_SIZE << "): ACMR " << cooked.acmr(false) << " -> "
+                      << cooked.acmr(true) << ", ATVR " << cooked.atvr(false) << " -> " << cooked.atvr(true) << std::endl;
+        }
+        modelArrived = true;
+    });
 
     // cube VAO
     unsigned int cubeVAO, cubeVBO;
@@ -350,6 +526,18 @@ int main()
     glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
     glEnableVertexAttribArray(0);
 
+    // per-instance wall data on the same VAO (filled once the maze is built)
+    unsigned int wallInstanceVBO;
+    glGenBuffers(1, &wallInstanceVBO);
+    glBindBuffer(GL_ARRAY_BUFFER, wallInstanceVBO);
+    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(WallInstance), (void*)offsetof(WallInstance, center));
+    glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, sizeof(WallInstance), (void*)offsetof(WallInstance, size));
+    glVertexAttribPointer(3, 3, GL_FLOAT, GL_FALSE, sizeof(WallInstance), (void*)offsetof(WallInstance, tint));
+    for (GLuint attr = 1; attr <= 3; attr++) {
+        glEnableVertexAttribArray(attr);
+        glVertexAttribDivisor(attr, 1);
+    }
+
     // skybox VAO
     unsigned int skyboxVAO, skyboxVBO;
     glGenVertexArrays(1, &skyboxVAO);
@@ -360,6 +548,16 @@ int main()
     glEnableVertexAttribArray(0);
     glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
 
+    // model proxy VAO: cube positions only, the wall shader's per-instance inputs
+    // come from generic attribute values set per draw
+    unsigned int proxyVAO;
+    glGenVertexArrays(1, &proxyVAO);
+    glBindVertexArray(proxyVAO);
+    glBindBuffer(GL_ARRAY_BUFFER, cubeVBO);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
+    glEnableVertexAttribArray(0);
+    glBindVertexArray(0);
+
     // load skybox textures
     vector<string> faces = {
         FileSystem::getPath("resources/textures/skybox/right.jpg"),
@@ -369,14 +567,15 @@ int main()
         FileSystem::getPath("resources/textures/skybox/front.jpg"),
         FileSystem::getPath("resources/textures/skybox/back.jpg")
     };
-    unsigned int cubemapTexture = loadCubemap(faces);
+    // flat clear-colored sky until all six faces are in
+    unsigned int cubemapTexture = createPlaceholderCubemap(46, 46, 56);
+    loadCubemapAsync(assetLoader, faces, cubemapTexture);
     skyboxShader.use(); skyboxShader.setInt("skybox", 0);
 
     // load wall texture (place your wall.jpg at resources/textures/wall.jpg)
-    unsigned int wallTexture = loadTexture(FileSystem::getPath("resources/textures/brickwall.jpg"));
-    if (!wallTexture) {
-        std::cerr << "Warning: wall texture failed to load. Walls will appear tinted.\n";
-    }
+    // plain gray until then; if it fails to load, walls stay gray and tinted
+    unsigned int wallTexture = createPlaceholderTexture2D(160, 160, 160);
+    loadTextureAsync(assetLoader, FileSystem::getPath("resources/textures/brickwall.jpg"), wallTexture);
 
     // ----------------- BUILD MAZE -----------------
     platforms.clear();
@@ -402,8 +601,146 @@ int main()
     obstacles.push_back({ glm::vec3(2.0f, 0.0f, 10.0f), glm::vec3(4.0f, 1.6f, 12.0f) });
     obstacles.push_back({ glm::vec3(-8.0f, 0.0f, -3.0f), glm::vec3(-6.5f, 1.6f, -1.0f) });
 
+    // merge touching/contained walls so collision and drawing see fewer boxes
+    size_t wallsBefore = obstacles.size();
+    coalesceBoxes(obstacles);
+    if (options.diagnostics())
+        std::cout << "Obstacles: " << wallsBefore << " -> " << obstacles.size() << " boxes after coalescing" << std::endl;
+
+    // broadphases and height index over the finished maze
+    collisionWorld.rebuild();
+
+    // one instance per box for drawing, and the same boxes baked into one world-space mesh
+    vector<uint32_t> allMazeBoxes(platforms.size() + obstacles.size());
+    for (uint32_t i = 0; i < allMazeBoxes.size(); i++) allMazeBoxes[i] = i;
+    GLsizei wallInstanceCount = uploadWallInstances(wallInstanceVBO, allMazeBoxes);
+    bool wallInstancesCulled = false; // instance buffer holds a culled subset
+    StaticMazeMesh staticMaze;
+    staticMaze.build(platforms, obstacles);
+
+    // visible sets for eyes below the wall tops, over the collision BVH's obstacles
+    WorkerPool workerPool;
+    MazePVS mazePvs;
+    double pvsStart = seconds();
+    mazePvs.build(platforms, obstacles, collisionWorld.getBVH(), PvsSettings(), &workerPool);
+    if (options.diagnostics())
+        std::cout << "PVS: " << mazePvs.cellCount() << " cells, " << mazePvs.averageSetSize() << " of " << allMazeBoxes.size()
+                  << " boxes per cell on average, built in " << (seconds() - pvsStart) * 1000.0 << " ms" << std::endl;
+
+    OcclusionCuller occlusionCuller;
+    vector<uint32_t> occluderCandidates;
+
+    // indirect commands: room for one command per maze box and per model mesh each
+    // frame (resized when the model arrives)
+    IndirectCommandBuffer drawCommands;
+    if (indirectApi.available())
+        drawCommands.create(indirectApi, (allMazeBoxes.size() + packedModel.meshCount()) * sizeof(DrawElementsIndirectCommand));
+
+    // view / projection for every shader, written once per frame
+    FrameUniformRing frameUniforms;
+    frameUniforms.create(&indirectApi);
+    vector<DrawArraysIndirectCommand> wallRunCommands;
+
+    // culling inputs: platform SoA for the SIMD test, model bounds in model space
+    // (a person-sized box until the model's own are known)
+    BoxSoA platformSoa;
+    platformSoa.assign(platforms);
+    Box modelBounds = { glm::vec3(-0.4f, 0.0f, -0.4f), glm::vec3(0.4f, 1.8f, 0.4f) };
+    vector<uint32_t> visibleBoxes;
+    CullStats cullStats;
+    double lastTitleUpdate = 0.0;
+
+    // per-frame draw inputs, set in the main loop and read by the drawers below
+    glm::mat4 projection(1.0f), view(1.0f), skyView(1.0f), modelMat(1.0f);
+    bool mazeCulled = false, indirect = false;
+
+    // GPU (timestamp queries) and CPU time per pass, in the title bar and --timings log
+    PassTimer passTimer;
+    int cullPass = passTimer.addPass("cull", false); // CPU work only, no GL commands to time
+    int modelPass = passTimer.addPass("model");
+    int mazePass = passTimer.addPass("maze");
+    int skyPass = passTimer.addPass("sky");
+    passTimer.create();
+    if (!options.timingsPath.empty() && !passTimer.openLog(options.timingsPath))
+        std::cerr << "Can't open timings log " << options.timingsPath << std::endl;
+    uint64_t frameNumber = 0;
+
+    // every draw goes through the render queue: items are sorted by state and
+    // replayed through a cache that skips repeated program / texture / VAO binds
+    GLStateCache glState;
+    RenderQueue renderQueue;
+    uint32_t modelDrawer = renderQueue.addDrawer([&](GLStateCache& state, uint32_t) {
+        passTimer.begin(modelPass);
+        modelShader.setMat4("model", modelMat);
+        if (!indirect || !packedModel.draw(modelShader, drawCommands)) packedModel.drawDirect(modelShader);
+        // binds (and unbinds) its own vertex array and textures
+        state.invalidateVertexArray();
+        state.invalidateTextures();
+        passTimer.end(modelPass);
+    });
+    // the model's bounding box in the wall shader, drawn until the model is resident
+    uint32_t proxyDrawer = renderQueue.addDrawer([&](GLStateCache&, uint32_t) {
+        passTimer.begin(modelPass);
+        Box box = transformBox(modelMat, modelBounds);
+        glm::vec3 center = (box.min + box.max) * 0.5f, size = box.max - box.min;
+        glVertexAttrib3f(1, center.x, center.y, center.z);
+        glVertexAttrib3f(2, size.x, size.y, size.z);
+        glVertexAttrib3f(3, 0.55f, 0.65f, 0.9f);
+        glDrawArrays(GL_TRIANGLES, 0, 36);
+        passTimer.end(modelPass);
+    });
+    uint32_t mazeDrawer = renderQueue.addDrawer([&](GLStateCache&, uint32_t) {
+        passTimer.begin(mazePass);
+        // platforms and walls with the tiled wall texture (platform tint is per instance)
+        // draw platforms and obstacles (walls) in one call, tints come per vertex / per instance
+        if (drawBakedMaze) {
+            // one indirect command per run of consecutive boxes, direct draws as the fallback
+            if (!indirect || !staticMaze.drawBoxListIndirect(mazeCulled ? visibleBoxes : allMazeBoxes, drawCommands)) {
+                if (mazeCulled) staticMaze.drawBoxList(visibleBoxes);
+                else staticMaze.draw();
+            }
+        }
+        else if (indirect) {
+            // the instance buffer keeps every box; runs pick theirs through baseInstance
+            if (wallInstancesCulled) {
+                wallInstanceCount = uploadWallInstances(wallInstanceVBO, allMazeBoxes);
+                wallInstancesCulled = false;
+            }
+            wallRunCommands.clear();
+            forEachBoxRun(mazeCulled ? visibleBoxes : allMazeBoxes, [&](uint32_t first, uint32_t count) {
+                wallRunCommands.push_back({ 36, count, 0, first });
+            });
+            const void* runs;
+            if (drawCommands.write(wallRunCommands.data(), wallRunCommands.size(), runs)) {
+                drawCommands.bind();
+                indirectApi.multiDrawArraysIndirect(GL_TRIANGLES, runs, static_cast<GLsizei>(wallRunCommands.size()), 0);
+            }
+            else {
+                glDrawArraysInstanced(GL_TRIANGLES, 0, 36, wallInstanceCount);
+            }
+        }
+        else {
+            if (mazeCulled) {
+                wallInstanceCount = uploadWallInstances(wallInstanceVBO, visibleBoxes);
+                wallInstancesCulled = true;
+            }
+            else if (wallInstancesCulled) {
+                wallInstanceCount = uploadWallInstances(wallInstanceVBO, allMazeBoxes);
+                wallInstancesCulled = false;
+            }
+            glDrawArraysInstanced(GL_TRIANGLES, 0, 36, wallInstanceCount);
+        }
+        passTimer.end(mazePass);
+    });
+    uint32_t skyDrawer = renderQueue.addDrawer([&](GLStateCache&, uint32_t) {
+        passTimer.begin(skyPass);
+        glDrawArrays(GL_TRIANGLES, 0, 36);
+        passTimer.end(skyPass);
+    });
+
     // ensure object starts in an open area
     objectPos = glm::vec3(-17.0f, 0.0f, -17.0f);
+    playerAgent = collisionWorld.addAgent(objectPos, objectRadius);
 
     // initial camera computed from camYaw/camPitch
     {
@@ -416,14 +753,42 @@ int main()
         camera.Front = forward;
     }
 
+    // headless frame times (CPU submit + glFinish, so llvmpipe's work is included);
+    // those runs wait for every asset so all timed frames draw the same scene
+    vector<double> frameTimes;
+    if (options.headless) {
+        frameTimes.reserve(options.frames);
+        assetLoader.finishAll();
+    }
+    if (scriptedInput) firstMouse = false; // script deltas are relative to lastX / lastY from the start
+
     // Main loop
-    while (!glfwWindowShouldClose(window))
+    while (options.headless ? scriptFrame < options.frames && !headlessQuit : !glfwWindowShouldClose(window))
     {
-        float currentFrame = static_cast<float>(glfwGetTime());
+        double frameStart = seconds();
+        float currentFrame = options.headless ? scriptFrame * options.timeStep : static_cast<float>(glfwGetTime());
         deltaTime = currentFrame - lastFrame;
         lastFrame = currentFrame;
 
+        if (scriptedInput) {
+            // scripted cursor / wheel go through the same callbacks as GLFW's
+            float dx, dy;
+            inputScript.mouseDelta(scriptFrame, dx, dy);
+            if (dx != 0.0f || dy != 0.0f) mouse_callback(window, lastX + dx, lastY + dy);
+            float wheel = inputScript.scroll(scriptFrame);
+            if (wheel != 0.0f) scroll_callback(window, 0.0, wheel);
+        }
         processInput(window);
+        passTimer.beginFrame(frameNumber++);
+
+        // finished decodes go to GL within the budget; uploads bind behind the state cache's back
+        if (assetLoader.pump(ASSET_UPLOAD_BUDGET_MS)) glState.invalidate();
+        if (packedModel.meshCount()) modelBounds = packedModel.bounds(); // known once its upload starts
+        if (modelArrived) {
+            modelArrived = false;
+            if (indirectApi.available())
+                drawCommands.create(indirectApi, (allMazeBoxes.size() + packedModel.meshCount()) * sizeof(DrawElementsIndirectCommand));
+        }
 
         // camera: compute behind-the-object position using yaw/pitch/distance
         // camera: compute behind-the-object position using yaw/pitch/distance
@@ -448,89 +813,221 @@ int main()
         glClearColor(0.18f, 0.18f, 0.22f, 1.0f);
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-        // Model shader (used for the model)
-        modelShader.use();
-        glm::mat4 projection = glm::perspective(glm::radians(camera.Zoom), (float)SCR_WIDTH / (float)SCR_HEIGHT, 0.1f, 100.0f);
-        glm::mat4 view = glm::lookAt(camera.Position, camTarget, glm::vec3(0.0f, 1.0f, 0.0f));
-        modelShader.setMat4("projection", projection);
-        modelShader.setMat4("view", view);
+        projection = glm::perspective(glm::radians(camera.Zoom), (float)options.width / (float)options.height, 0.1f, 100.0f);
+        view = glm::lookAt(camera.Position, camTarget, glm::vec3(0.0f, 1.0f, 0.0f));
 
         // draw model at objectPos
-        glm::mat4 modelMat = glm::mat4(1.0f);
+        modelMat = glm::mat4(1.0f);
         modelMat = glm::translate(modelMat, objectPos);
         modelMat = glm::rotate(modelMat, glm::radians(-camYaw + 90.0f), glm::vec3(0.0f, 1.0f, 0.0f));
         modelMat = glm::scale(modelMat, glm::vec3(1.0f));
-        modelShader.setMat4("model", modelMat);
-        ourModel.Draw(modelShader);
-
-        // draw platforms using a slightly tinted texture (reuse wall shader but with a different tint)
-        glUseProgram(wallProg);
-        glUniformMatrix4fv(wall_uView, 1, GL_FALSE, glm::value_ptr(view));
-        glUniformMatrix4fv(wall_uProj, 1, GL_FALSE, glm::value_ptr(projection));
-        // bind wall texture to unit 0
-        glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_2D, wallTexture);
-        glUniform1i(wall_uTex, 0);
-
-        // tile scale (how many texture repeats per world unit) - tweak to taste
-        float uvScale = 0.25f; // lower = larger tiles, higher = more repeats
-        glUniform1f(wall_uUVScale, uvScale);
-
-        // draw platforms (tinted slightly darker)
-        for (auto& p : platforms) {
-            glm::mat4 pm = glm::mat4(1.0f);
-            glm::vec3 size = p.max - p.min;
-            glm::vec3 center = (p.min + p.max) * 0.5f;
-            pm = glm::translate(pm, center);
-            pm = glm::scale(pm, size);
-            glUniformMatrix4fv(wall_uModel, 1, GL_FALSE, glm::value_ptr(pm));
-            glUniform3f(wall_uTint, 0.9f, 0.9f, 0.9f); // near-white tint for floor
-            glBindVertexArray(cubeVAO);
-            glDrawArrays(GL_TRIANGLES, 0, 36);
-        }
 
-        // draw obstacles (walls) with stronger tint
-        for (auto& o : obstacles) {
-            glm::mat4 om = glm::mat4(1.0f);
-            glm::vec3 size = o.max - o.min;
-            glm::vec3 center = (o.min + o.max) * 0.5f;
-            om = glm::translate(om, center);
-            om = glm::scale(om, size);
-            glUniformMatrix4fv(wall_uModel, 1, GL_FALSE, glm::value_ptr(om));
-            glUniform3f(wall_uTint, 1.0f, 1.0f, 1.0f); // neutral tint (texture shows)
-            glDrawArrays(GL_TRIANGLES, 0, 36);
+        passTimer.begin(cullPass);
+        // maze boxes to draw: the camera cell's PVS (when there is one) and/or the
+        // frustum test; the model only goes through the frustum test
+        Frustum frustum = extractFrustum(projection * view);
+        size_t mazeBoxCount = allMazeBoxes.size();
+        const uint32_t* pvsSet = nullptr;
+        cullStats.pvsUsed = pvsEnabled && mazePvs.visibleFrom(camera.Position, pvsSet, cullStats.pvsBoxes);
+        if (cullStats.pvsUsed) {
+            visibleBoxes.clear();
+            for (size_t i = 0; i < cullStats.pvsBoxes; i++)
+                if (!frustumCullingEnabled || frustumOverlapsBox(frustum, mazeBox(pvsSet[i]))) visibleBoxes.push_back(pvsSet[i]);
+        }
+        else if (frustumCullingEnabled) {
+            cullMazeBoxes(frustum, platformSoa, visibleBoxes);
+        }
+        mazeCulled = cullStats.pvsUsed || frustumCullingEnabled;
+        cullStats.modelVisible = !frustumCullingEnabled || frustumOverlapsBox(frustum, transformBox(modelMat, modelBounds));
+
+        // occlusion: the biggest on-screen walls among the candidates go into a small
+        // software depth buffer, then every candidate (and the model) is tested against it
+        cullStats.occludedBoxes = 0;
+        if (occlusionCullingEnabled) {
+            if (!mazeCulled) {
+                visibleBoxes = allMazeBoxes;
+                mazeCulled = true;
+            }
+            occluderCandidates.clear();
+            for (uint32_t id : visibleBoxes)
+                if (id >= platforms.size()) occluderCandidates.push_back(id - static_cast<uint32_t>(platforms.size()));
+            occlusionCuller.beginFrame(projection * view, camera.Position);
+            occlusionCuller.addOccluders(obstacles, occluderCandidates.data(), occluderCandidates.size(), MAX_OCCLUDERS);
+            occlusionCuller.rasterize(&workerPool);
+            size_t kept = 0;
+            for (uint32_t id : visibleBoxes)
+                if (occlusionCuller.boxVisible(mazeBox(id))) visibleBoxes[kept++] = id;
+            cullStats.occludedBoxes = visibleBoxes.size() - kept;
+            visibleBoxes.resize(kept);
+            if (cullStats.modelVisible) cullStats.modelVisible = occlusionCuller.boxVisible(transformBox(modelMat, modelBounds));
+        }
+        cullStats.visibleBoxes = mazeCulled ? visibleBoxes.size() : mazeBoxCount;
+        cullStats.culledBoxes = mazeBoxCount - cullStats.visibleBoxes;
+
+        passTimer.end(cullPass);
+
+        // queue this frame's draws: model, maze, then the skybox in its own pass
+        skyView = glm::mat4(glm::mat3(glm::lookAt(camera.Position, camera.Position + camera.Front, glm::vec3(0.0f, 1.0f, 0.0f))));
+        renderQueue.clear();
+        // model LOD: pixels per model unit at the nearest its bounding sphere gets
+        // to the camera, so the side facing the camera never pops past the limit
+        if (packedModel.resident()) {
+            glm::vec3 center = glm::vec3(modelMat * glm::vec4(boxCenter(modelBounds), 1.0f));
+            float radius = glm::length(modelBounds.max - modelBounds.min) * 0.5f;
+            float distance = std::max(glm::length(center - camera.Position) - radius, 0.1f);
+            float pixelsPerUnit = options.height / (2.0f * distance * tan(glm::radians(camera.Zoom) * 0.5f));
+            packedModel.selectLod(lodEnabled ? pixelsPerUnit : 1.0e30f, LOD_PIXEL_ERROR);
+        }
+        RenderQueue::Item item;
+        if (cullStats.modelVisible && packedModel.resident()) {
+            item.program = modelShader.ID;
+            item.depth = glm::length(objectPos - camera.Position);
+            item.drawer = modelDrawer;
+            renderQueue.submit(item);
+        }
+        else if (cullStats.modelVisible) {
+            item.program = wallProg;
+            item.texture = wallTexture;
+            item.vao = proxyVAO;
+            item.depth = glm::length(objectPos - camera.Position);
+            item.drawer = proxyDrawer;
+            renderQueue.submit(item);
+        }
+        item = RenderQueue::Item();
+        item.program = wallProg;
+        item.texture = wallTexture;
+        item.vao = drawBakedMaze ? staticMaze.VAO : cubeVAO;
+        item.drawer = mazeDrawer;
+        renderQueue.submit(item);
+        item = RenderQueue::Item();
+        item.pass = RenderPass::Sky;
+        item.program = skyboxShader.ID;
+        item.textureTarget = GL_TEXTURE_CUBE_MAP;
+        item.texture = cubemapTexture;
+        item.vao = skyboxVAO;
+        item.drawer = skyDrawer;
+        renderQueue.submit(item);
+
+        indirect = useIndirectDraws && indirectApi.available();
+        if (indirect) drawCommands.beginFrame();
+        frameUniforms.update({ view, projection, projection * view, skyView, glm::vec4(camera.Position, 1.0f) });
+        renderQueue.flush(glState);
+        passTimer.endFrame();
+        frameUniforms.endFrame();
+        if (indirect) drawCommands.endFrame();
+        if (frameNumber == 1 && options.diagnostics())
+            std::cout << "First frame after " << (seconds() - launchTime) * 1000.0 << " ms, " << assetLoader.pending()
+                      << " assets still loading" << std::endl;
+
+        if (options.headless) {
+            glFinish();
+            frameTimes.push_back((seconds() - frameStart) * 1000.0);
+            scriptFrame++;
+            continue;
         }
 
-        // skybox
-        glDepthFunc(GL_LEQUAL);
-        skyboxShader.use();
-        glm::mat4 skyView = glm::mat4(glm::mat3(glm::lookAt(camera.Position, camera.Position + camera.Front, glm::vec3(0.0f, 1.0f, 0.0f))));
-        skyboxShader.setMat4("view", skyView);
-        skyboxShader.setMat4("projection", projection);
-        glBindVertexArray(skyboxVAO);
-        glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_CUBE_MAP, cubemapTexture);
-        glDrawArrays(GL_TRIANGLES, 0, 36);
-        glDepthFunc(GL_LESS);
+        // culling counts in the title bar, twice a second
+        if (currentFrame - lastTitleUpdate > 0.5) {
+            lastTitleUpdate = currentFrame;
+            string title = "3rd-Person Movement & Maze (textured walls) | boxes visible " + to_string(cullStats.visibleBoxes) +
+                           " culled " + to_string(cullStats.culledBoxes) + " | pvs " +
+                           (cullStats.pvsUsed ? to_string(cullStats.pvsBoxes) : string("-")) + " | occluded " +
+                           to_string(cullStats.occludedBoxes) + " | model " +
+                           (cullStats.modelVisible ? "drawn" : "culled") + " | lod " +
+                           (lodEnabled ? to_string(packedModel.lodLevel()) : string("off")) + " " +
+                           to_string(packedModel.drawnTriangles()) + " tris | gpu/cpu ms " + formatPassTimings(passTimer);
+            glfwSetWindowTitle(window, title.c_str());
+        }
 
         glfwSwapBuffers(window);
         glfwPollEvents();
+        if (scriptedInput) scriptFrame++;
+    }
+
+    if (options.headless && !frameTimes.empty()) {
+        if (!options.capturePath.empty() && !offscreen.writePPM(options.capturePath))
+            std::cerr << "Headless: can't write " << options.capturePath << std::endl;
+        vector<double> sorted = frameTimes;
+        std::sort(sorted.begin(), sorted.end());
+        double total = 0.0;
+        for (double t : frameTimes) total += t;
+        std::cout << "Frames: " << frameTimes.size() << ", ms mean " << total / frameTimes.size() << " median "
+                  << sorted[sorted.size() / 2] << " p95 " << sorted[std::min(sorted.size() - 1, sorted.size() * 95 / 100)]
+                  << " min " << sorted.front() << " max " << sorted.back() << std::endl;
     }
+    passTimer.finish();
+    for (const PassTimer::Timing& t : passTimer.results())
+        if (t.samples) {
+            std::cout << "Pass " << t.name << ": ";
+            if (t.gpu) std::cout << "gpu " << t.gpuTotal / t.samples << " ms, ";
+            std::cout << "cpu " << t.cpuTotal / t.samples << " ms over " << t.samples << " frames" << std::endl;
+        }
+    if (passTimer.droppedFrames()) std::cout << "Timer frames dropped: " << passTimer.droppedFrames() << std::endl;
 
     // cleanup
     glDeleteProgram(wallProg);
     glDeleteVertexArrays(1, &cubeVAO);
     glDeleteBuffers(1, &cubeVBO);
-
-    glfwTerminate();
+    glDeleteBuffers(1, &wallInstanceVBO);
+    glDeleteVertexArrays(1, &proxyVAO);
+    staticMaze.release();
+    packedModel.release();
+    drawCommands.release();
+    frameUniforms.release();
+    passTimer.release();
+    offscreen.release();
+
+    if (window) glfwTerminate();
     return 0;
 }
 
 // ---------------- Input & collision logic ----------------
 void processInput(GLFWwindow* window)
 {
-    if (glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS)
-        glfwSetWindowShouldClose(window, true);
+    if (keyDown(window, GLFW_KEY_ESCAPE)) {
+        if (window) glfwSetWindowShouldClose(window, true);
+        else headlessQuit = true; // headless: end after this frame
+    }
+
+    // broadphase selection (1 = brute force, 2 = BVH, 3 = grid, 4 = sweep and prune)
+    if (keyDown(window, GLFW_KEY_1)) collisionWorld.broadphase = Broadphase::BruteForce;
+    if (keyDown(window, GLFW_KEY_2)) collisionWorld.broadphase = Broadphase::BVH;
+    if (keyDown(window, GLFW_KEY_3)) collisionWorld.broadphase = Broadphase::Grid;
+    if (keyDown(window, GLFW_KEY_4)) collisionWorld.broadphase = Broadphase::SweepAndPrune;
+
+    // wall draw path (B = baked maze mesh, I = instanced boxes)
+    if (keyDown(window, GLFW_KEY_B)) drawBakedMaze = true;
+    if (keyDown(window, GLFW_KEY_I)) drawBakedMaze = false;
+
+    // frustum culling toggle, edge-triggered so holding C doesn't flicker
+    static bool cullKeyDown = false;
+    bool cullKey = keyDown(window, GLFW_KEY_C);
+    if (cullKey && !cullKeyDown) frustumCullingEnabled = !frustumCullingEnabled;
+    cullKeyDown = cullKey;
+
+    // PVS toggle, same edge trigger
+    static bool pvsKeyDown = false;
+    bool pvsKey = keyDown(window, GLFW_KEY_P);
+    if (pvsKey && !pvsKeyDown) pvsEnabled = !pvsEnabled;
+    pvsKeyDown = pvsKey;
+
+    // occlusion culling toggle
+    static bool occlusionKeyDown = false;
+    bool occlusionKey = keyDown(window, GLFW_KEY_O);
+    if (occlusionKey && !occlusionKeyDown) occlusionCullingEnabled = !occlusionCullingEnabled;
+    occlusionKeyDown = occlusionKey;
+
+    // indirect draw toggle
+    static bool indirectKeyDown = false;
+    bool indirectKey = keyDown(window, GLFW_KEY_M);
+    if (indirectKey && !indirectKeyDown) useIndirectDraws = !useIndirectDraws;
+    indirectKeyDown = indirectKey;
+
+    // model LOD toggle
+    static bool lodKeyDown = false;
+    bool lodKey = keyDown(window, GLFW_KEY_L);
+    if (lodKey && !lodKeyDown) lodEnabled = !lodEnabled;
+    lodKeyDown = lodKey;
 
     // horizontal forward/right from camYaw (movement follows camera heading)
     float yawRad = glm::radians(camYaw);
@@ -540,30 +1037,18 @@ void processInput(GLFWwindow* window)
     float velocity = objectSpeed * deltaTime;
     glm::vec3 desired = objectPos;
 
-    if (glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS) desired += forward * velocity;
-    if (glfwGetKey(window, GLFW_KEY_S) == GLFW_PRESS) desired -= forward * velocity;
-    if (glfwGetKey(window, GLFW_KEY_A) == GLFW_PRESS) desired -= right * velocity;
-    if (glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS) desired += right * velocity;
+    if (keyDown(window, GLFW_KEY_W)) desired += forward * velocity;
+    if (keyDown(window, GLFW_KEY_S)) desired -= forward * velocity;
+    if (keyDown(window, GLFW_KEY_A)) desired -= right * velocity;
+    if (keyDown(window, GLFW_KEY_D)) desired += right * velocity;
 
     desired.y = objectPos.y;
 
-    // collision handling with obstacles (slide)
-    bool collide = collidesWithAnyObstacle(desired, objectRadius);
-    if (!collide) {
-        objectPos = desired;
-    }
-    else {
-        glm::vec3 tryX = objectPos; tryX.x = desired.x;
-        if (!collidesWithAnyObstacle(tryX, objectRadius)) objectPos.x = tryX.x;
-        glm::vec3 tryZ = objectPos; tryZ.z = desired.z;
-        if (!collidesWithAnyObstacle(tryZ, objectRadius)) objectPos.z = tryZ.z;
-    }
-
-    // snap Y to highest platform under player's X/Z
-    float topY;
-    if (highestPlatformTopAtXZ(objectPos.x, objectPos.z, topY)) {
-        objectPos.y = topY;
-    }
+    // collision handling with obstacles: sweep the sphere along the whole move and
+    // slide along whatever it hits, so long frames cannot tunnel through thin walls,
+    // then snap Y to highest platform under player's X/Z
+    collisionWorld.prepareQueries();
+    collisionWorld.moveAgent(playerAgent, objectPos, objectRadius, desired - objectPos);
 }
 
 void framebuffer_size_callback(GLFWwindow* window, int width, int height)
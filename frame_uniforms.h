@@ -0,0 +1,135 @@
+#ifndef FRAME_UNIFORMS_H
+#define FRAME_UNIFORMS_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include "indirect_draw.h"
+
+#include <cstddef>
+#include <cstring>
+
+// Per-frame camera data shared by every shader through one std140 uniform
+// block, bound at FRAME_UNIFORM_BINDING:
+//
+//   layout(std140) uniform FrameData {
+//       mat4 view;
+//       mat4 projection;
+//       mat4 viewProj;
+//       mat4 skyView;   // view without the translation
+//       vec4 cameraPos; // xyz, w unused
+//   };
+//
+// GLSL 3.30 has no binding qualifier, so each program is pointed at the
+// binding point once with bindFrameUniforms.
+const GLuint FRAME_UNIFORM_BINDING = 0;
+
+struct FrameData {
+    glm::mat4 view;
+    glm::mat4 projection;
+    glm::mat4 viewProj;
+    glm::mat4 skyView;
+    glm::vec4 cameraPos;
+};
+static_assert(sizeof(FrameData) == 4 * 64 + 16, "FrameData must match the std140 block");
+
+// hook program's FrameData block (if it uses one) up to the shared binding point
+inline void bindFrameUniforms(GLuint program)
+{
+    GLuint block = glGetUniformBlockIndex(program, "FrameData");
+    if (block != GL_INVALID_INDEX) glUniformBlockBinding(program, block, FRAME_UNIFORM_BINDING);
+}
+
+// FrameData ring: FRAMES slots in one uniform buffer, written once per frame
+// and bound with glBindBufferRange, so no shader needs its own matrix uploads.
+// With persistent mapping (GL 4.4 / ARB_buffer_storage) the buffer stays
+// mapped; otherwise the slot is mapped unsynchronized each frame. Either way a
+// fence per slot keeps the CPU off data the GPU may still read.
+class FrameUniformRing {
+public:
+    static const int FRAMES = 3;
+
+    // api may be null or without buffer storage; then the 3.3 path is used
+    void create(const IndirectDrawApi* api = nullptr)
+    {
+        release();
+        GLint alignment = 256;
+        glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+        size_t a = static_cast<size_t>(alignment > 0 ? alignment : 256);
+        slotSize = (sizeof(FrameData) + a - 1) / a * a;
+        GLsizeiptr total = static_cast<GLsizeiptr>(slotSize * FRAMES);
+        glGenBuffers(1, &buffer);
+        glBindBuffer(GL_UNIFORM_BUFFER, buffer);
+        if (api && api->persistent()) {
+            GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+            api->bufferStorage(GL_UNIFORM_BUFFER, total, nullptr, flags);
+            mapped = static_cast<unsigned char*>(glMapBufferRange(GL_UNIFORM_BUFFER, 0, total, flags));
+        }
+        else {
+            glBufferData(GL_UNIFORM_BUFFER, total, nullptr, GL_STREAM_DRAW);
+        }
+        glBindBuffer(GL_UNIFORM_BUFFER, 0);
+    }
+
+    // write this frame's data into the next slot and bind it; call before the draws
+    void update(const FrameData& data)
+    {
+        if (!buffer) return;
+        slot = (slot + 1) % FRAMES;
+        if (fences[slot]) {
+            while (true) {
+                GLenum r = glClientWaitSync(fences[slot], GL_SYNC_FLUSH_COMMANDS_BIT, 1000000); // 1 ms
+                if (r == GL_ALREADY_SIGNALED || r == GL_CONDITION_SATISFIED || r == GL_WAIT_FAILED) break;
+            }
+            glDeleteSync(fences[slot]);
+            fences[slot] = 0;
+        }
+        GLintptr offset = static_cast<GLintptr>(slot * slotSize);
+        if (mapped) {
+            std::memcpy(mapped + offset, &data, sizeof(FrameData));
+        }
+        else {
+            glBindBuffer(GL_UNIFORM_BUFFER, buffer);
+            void* dst = glMapBufferRange(GL_UNIFORM_BUFFER, offset, sizeof(FrameData),
+                                         GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+            if (dst) {
+                std::memcpy(dst, &data, sizeof(FrameData));
+                glUnmapBuffer(GL_UNIFORM_BUFFER);
+            }
+            glBindBuffer(GL_UNIFORM_BUFFER, 0);
+        }
+        glBindBufferRange(GL_UNIFORM_BUFFER, FRAME_UNIFORM_BINDING, buffer, offset, sizeof(FrameData));
+    }
+
+    // after the frame's last draw
+    void endFrame()
+    {
+        if (buffer) fences[slot] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    }
+
+    void release()
+    {
+        if (!buffer) return;
+        for (GLsync& f : fences) {
+            if (f) glDeleteSync(f);
+            f = 0;
+        }
+        if (mapped) {
+            glBindBuffer(GL_UNIFORM_BUFFER, buffer);
+            glUnmapBuffer(GL_UNIFORM_BUFFER);
+            glBindBuffer(GL_UNIFORM_BUFFER, 0);
+        }
+        glDeleteBuffers(1, &buffer);
+        buffer = 0;
+        mapped = nullptr;
+    }
+
+private:
+    GLuint buffer = 0;
+    unsigned char* mapped = nullptr;
+    size_t slotSize = 0;
+    int slot = 0;
+    GLsync fences[FRAMES] = {};
+};
+
+#endif
@@ -0,0 +1,163 @@
+#ifndef FRUSTUM_CULLING_H
+#define FRUSTUM_CULLING_H
+
+#include <glm/glm.hpp>
+
+#include "collision.h"
+#include "box_soa.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+// View-frustum culling of AABBs. Planes come straight out of projection * view
+// (Gribb/Hartmann), normals pointing inwards. A box is outside as soon as its
+// corner furthest along a plane normal (the "p-vertex") is behind that plane.
+// The test is conservative: boxes near frustum corners may be kept, never dropped.
+
+struct Frustum {
+    glm::vec4 planes[6]; // xyz = unit normal, w = distance; left, right, bottom, top, near, far
+};
+
+inline Frustum extractFrustum(const glm::mat4& viewProj)
+{
+    // glm is column-major: row i is (m[0][i], m[1][i], m[2][i], m[3][i])
+    auto row = [&](int i) { return glm::vec4(viewProj[0][i], viewProj[1][i], viewProj[2][i], viewProj[3][i]); };
+    Frustum f;
+    f.planes[0] = row(3) + row(0);
+    f.planes[1] = row(3) - row(0);
+    f.planes[2] = row(3) + row(1);
+    f.planes[3] = row(3) - row(1);
+    f.planes[4] = row(3) + row(2);
+    f.planes[5] = row(3) - row(2);
+    for (glm::vec4& p : f.planes) p /= glm::length(glm::vec3(p));
+    return f;
+}
+
+// signed distance of the p-vertex of b to plane p; < 0 means b is fully behind it
+inline float planePositiveDistance(const glm::vec4& p, const Box& b)
+{
+    float x = p.x > 0.0f ? b.max.x : b.min.x;
+    float y = p.y > 0.0f ? b.max.y : b.min.y;
+    float z = p.z > 0.0f ? b.max.z : b.min.z;
+    return p.x * x + p.y * y + p.z * z + p.w;
+}
+
+inline bool frustumOverlapsBox(const Frustum& f, const Box& b)
+{
+    for (const glm::vec4& p : f.planes)
+        if (planePositiveDistance(p, b) < 0.0f) return false;
+    return true;
+}
+
+// bounds of box b after transform m (Arvo): used to cull the character model
+inline Box transformBox(const glm::mat4& m, const Box& b)
+{
+    glm::vec3 t(m[3]);
+    Box out = { t, t };
+    for (int i = 0; i < 3; i++) {
+        for (int j = 0; j < 3; j++) {
+            float e = m[j][i] * b.min[j];
+            float f = m[j][i] * b.max[j];
+            out.min[i] += std::min(e, f);
+            out.max[i] += std::max(e, f);
+        }
+    }
+    return out;
+}
+
+// ---------- frustum vs many boxes kernels ----------
+// outVisible[i] = 1 if soa box first + i is (possibly) inside the frustum.
+// The p-vertex for a plane is the same for every box, so each plane just picks
+// the min or max arrays; the sums run in the same order in every kernel.
+typedef void (*FrustumBoxesKernel)(const BoxSoA& soa, size_t first, size_t count, const Frustum& f, uint8_t* outVisible);
+
+struct FrustumPlaneArrays {
+    const float* x;
+    const float* y;
+    const float* z;
+};
+
+inline FrustumPlaneArrays planeArrays(const BoxSoA& soa, const glm::vec4& p)
+{
+    return { p.x > 0.0f ? soa.maxX.data() : soa.minX.data(), p.y > 0.0f ? soa.maxY.data() : soa.minY.data(),
+             p.z > 0.0f ? soa.maxZ.data() : soa.minZ.data() };
+}
+
+inline void frustumCullBoxesScalar(const BoxSoA& soa, size_t first, size_t count, const Frustum& f, uint8_t* outVisible)
+{
+    for (size_t i = 0; i < count; i++) outVisible[i] = 1;
+    for (const glm::vec4& p : f.planes) {
+        FrustumPlaneArrays a = planeArrays(soa, p);
+        for (size_t i = 0; i < count; i++) {
+            size_t o = first + i;
+            if (p.x * a.x[o] + p.y * a.y[o] + p.z * a.z[o] + p.w < 0.0f) outVisible[i] = 0;
+        }
+    }
+}
+
+#if BOX_SOA_X86
+inline void frustumCullBoxesSSE(const BoxSoA& soa, size_t first, size_t count, const Frustum& f, uint8_t* outVisible)
+{
+    FrustumPlaneArrays a[6];
+    for (int k = 0; k < 6; k++) a[k] = planeArrays(soa, f.planes[k]);
+    const __m128 zero = _mm_setzero_ps();
+    for (size_t i = 0; i < count; i += 4) {
+        size_t o = first + i;
+        __m128 outside = _mm_setzero_ps();
+        for (int k = 0; k < 6; k++) {
+            const glm::vec4& p = f.planes[k];
+            __m128 d = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(p.x), _mm_loadu_ps(a[k].x + o)),
+                                                        _mm_mul_ps(_mm_set1_ps(p.y), _mm_loadu_ps(a[k].y + o))),
+                                             _mm_mul_ps(_mm_set1_ps(p.z), _mm_loadu_ps(a[k].z + o))),
+                                  _mm_set1_ps(p.w));
+            outside = _mm_or_ps(outside, _mm_cmplt_ps(d, zero));
+        }
+        int mask = _mm_movemask_ps(outside);
+        size_t n = std::min<size_t>(4, count - i);
+        for (size_t j = 0; j < n; j++) outVisible[i + j] = (mask >> j) & 1 ? 0 : 1;
+    }
+}
+
+BOX_SOA_TARGET_AVX2
+inline void frustumCullBoxesAVX2(const BoxSoA& soa, size_t first, size_t count, const Frustum& f, uint8_t* outVisible)
+{
+    FrustumPlaneArrays a[6];
+    for (int k = 0; k < 6; k++) a[k] = planeArrays(soa, f.planes[k]);
+    const __m256 zero = _mm256_setzero_ps();
+    for (size_t i = 0; i < count; i += 8) {
+        size_t o = first + i;
+        __m256 outside = _mm256_setzero_ps();
+        for (int k = 0; k < 6; k++) {
+            const glm::vec4& p = f.planes[k];
+            __m256 d = _mm256_add_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(p.x), _mm256_loadu_ps(a[k].x + o)),
+                                                                 _mm256_mul_ps(_mm256_set1_ps(p.y), _mm256_loadu_ps(a[k].y + o))),
+                                                   _mm256_mul_ps(_mm256_set1_ps(p.z), _mm256_loadu_ps(a[k].z + o))),
+                                     _mm256_set1_ps(p.w));
+            outside = _mm256_or_ps(outside, _mm256_cmp_ps(d, zero, _CMP_LT_OQ));
+        }
+        int mask = _mm256_movemask_ps(outside);
+        size_t n = std::min<size_t>(8, count - i);
+        for (size_t j = 0; j < n; j++) outVisible[i + j] = (mask >> j) & 1 ? 0 : 1;
+    }
+}
+#endif
+
+inline FrustumBoxesKernel frustumKernelForLevel(SimdLevel level)
+{
+#if BOX_SOA_X86
+    if (level == SimdLevel::AVX2) return frustumCullBoxesAVX2;
+    if (level == SimdLevel::SSE) return frustumCullBoxesSSE;
+#endif
+    (void)level;
+    return frustumCullBoxesScalar;
+}
+
+inline void frustumCullBoxes(const BoxSoA& soa, size_t first, size_t count, const Frustum& f, uint8_t* outVisible)
+{
+    static FrustumBoxesKernel kernel = frustumKernelForLevel(detectSimdLevel());
+    kernel(soa, first, count, f, outVisible);
+}
+
+#endif
@@ -0,0 +1,225 @@
+#ifndef GPU_TIMER_H
+#define GPU_TIMER_H
+
+#include <glad/glad.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+// Per-pass GPU and CPU timings. Each pass is bracketed by two GL_TIMESTAMP
+// queries (glQueryCounter, core since 3.3) plus CPU clock reads, so passes can
+// sit anywhere in the frame and don't have to nest like GL_TIME_ELAPSED ranges.
+// Queries live in a ring of FRAMES frames and are only read back once
+// GL_QUERY_RESULT_AVAILABLE says so: results arrive a few frames late but
+// never stall the pipeline. A frame whose queries are still pending when its
+// slot comes round again is dropped.
+//
+// The CPU time of a pass is how long the submitting code took, the GPU time is
+// the distance between the two timestamps on the GPU timeline. Passes that
+// issue no GL commands (culling, say) are registered CPU-only: a timestamp
+// pair around them would only measure queue latency.
+class PassTimer {
+public:
+    static const int FRAMES = 4;
+
+    struct Timing {
+        std::string name;
+        bool gpu = true;                           // false: CPU-only pass, gpu fields stay 0
+        double gpuMs = 0.0, cpuMs = 0.0;       // last resolved frame
+        double gpuAverage = 0.0, cpuAverage = 0.0; // smoothed, for the readout
+        uint64_t samples = 0;
+        double gpuTotal = 0.0, cpuTotal = 0.0;
+    };
+
+    ~PassTimer() { release(); }
+
+    // register a pass before the first frame; returns its index
+    int addPass(const std::string& name, bool gpu = true)
+    {
+        Timing t;
+        t.name = name;
+        t.gpu = gpu;
+        timings.push_back(t);
+        return static_cast<int>(timings.size() - 1);
+    }
+
+    void create()
+    {
+        release();
+        size_t perFrame = timings.size() * 2;
+        for (Slot& s : slots) {
+            s.queries.resize(perFrame);
+            glGenQueries(static_cast<GLsizei>(perFrame), s.queries.data());
+            s.cpuStart.assign(timings.size(), 0.0);
+            s.cpuMs.assign(timings.size(), 0.0);
+            s.used.assign(timings.size(), 0);
+        }
+        created = true;
+    }
+
+    // pick up finished frames and start writing the next slot
+    void beginFrame(uint64_t frameNumber)
+    {
+        if (!created) return;
+        collect();
+        current = (current + 1) % FRAMES;
+        Slot& s = slots[current];
+        if (s.pending) {
+            dropped++;
+            s.pending = false;
+        }
+        s.frame = frameNumber;
+        std::fill(s.used.begin(), s.used.end(), 0);
+    }
+
+    void begin(int pass)
+    {
+        if (!created) return;
+        Slot& s = slots[current];
+        if (timings[pass].gpu) glQueryCounter(s.queries[pass * 2], GL_TIMESTAMP);
+        s.cpuStart[pass] = now();
+    }
+
+    void end(int pass)
+    {
+        if (!created) return;
+        Slot& s = slots[current];
+        s.cpuMs[pass] = (now() - s.cpuStart[pass]) * 1000.0;
+        if (timings[pass].gpu) glQueryCounter(s.queries[pass * 2 + 1], GL_TIMESTAMP);
+        s.used[pass] = 1;
+    }
+
+    void endFrame()
+    {
+        if (!created) return;
+        Slot& s = slots[current];
+        for (uint8_t u : s.used) s.pending |= u != 0;
+        s.order = ++issued;
+    }
+
+    // at shutdown: wait for the GPU and read back every frame still in flight
+    void finish()
+    {
+        if (!created) return;
+        glFinish();
+        collect();
+    }
+
+    const std::vector<Timing>& results() const { return timings; }
+    uint64_t droppedFrames() const { return dropped; }
+
+    // one line per pass and frame: CSV (frame,pass,gpu_ms,cpu_ms) or, for a .json
+    // path, an array of {"frame", "pass", "gpu_ms", "cpu_ms"} objects; gpu_ms is
+    // empty (CSV) or null (JSON) for CPU-only passes
+    bool openLog(const std::string& path)
+    {
+        closeLog();
+        log = std::fopen(path.c_str(), "w");
+        if (!log) return false;
+        json = path.size() >= 5 && path.compare(path.size() - 5, 5, ".json") == 0;
+        std::fputs(json ? "[\n" : "frame,pass,gpu_ms,cpu_ms\n", log);
+        logRows = 0;
+        return true;
+    }
+
+    void closeLog()
+    {
+        if (!log) return;
+        if (json) std::fputs(logRows ? "\n]\n" : "]\n", log);
+        std::fclose(log);
+        log = nullptr;
+    }
+
+    void release()
+    {
+        closeLog();
+        if (!created) return;
+        for (Slot& s : slots) {
+            glDeleteQueries(static_cast<GLsizei>(s.queries.size()), s.queries.data());
+            s.queries.clear();
+            s.pending = false;
+        }
+        created = false;
+    }
+
+private:
+    struct Slot {
+        std::vector<GLuint> queries; // begin / end timestamp per pass
+        std::vector<double> cpuStart, cpuMs;
+        std::vector<uint8_t> used;   // pass ran this frame
+        uint64_t frame = 0;
+        uint64_t order = 0;          // issue order, oldest is read back first
+        bool pending = false;
+    };
+
+    std::vector<Timing> timings;
+    Slot slots[FRAMES];
+    int current = 0;
+    uint64_t issued = 0, dropped = 0;
+    bool created = false;
+    FILE* log = nullptr;
+    bool json = false;
+    uint64_t logRows = 0;
+
+    static double now()
+    {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    // read back pending frames oldest first, stopping at the first one the GPU hasn't finished
+    void collect()
+    {
+        while (true) {
+            Slot* oldest = nullptr;
+            for (Slot& s : slots)
+                if (s.pending && (!oldest || s.order < oldest->order)) oldest = &s;
+            if (!oldest) return;
+            GLuint last = 0;
+            for (size_t p = 0; p < timings.size(); p++)
+                if (oldest->used[p] && timings[p].gpu) last = oldest->queries[p * 2 + 1];
+            GLint available = 1; // only CPU passes ran: nothing to wait for
+            if (last) glGetQueryObjectiv(last, GL_QUERY_RESULT_AVAILABLE, &available);
+            if (!available) return;
+            resolve(*oldest);
+            oldest->pending = false;
+        }
+    }
+
+    void resolve(const Slot& s)
+    {
+        const double smoothing = 0.1;
+        for (size_t p = 0; p < timings.size(); p++) {
+            if (!s.used[p]) continue;
+            Timing& t = timings[p];
+            if (t.gpu) {
+                GLuint64 start = 0, end = 0;
+                glGetQueryObjectui64v(s.queries[p * 2], GL_QUERY_RESULT, &start);
+                glGetQueryObjectui64v(s.queries[p * 2 + 1], GL_QUERY_RESULT, &end);
+                t.gpuMs = end > start ? (end - start) / 1.0e6 : 0.0;
+            }
+            t.cpuMs = s.cpuMs[p];
+            t.gpuAverage = t.samples ? t.gpuAverage + (t.gpuMs - t.gpuAverage) * smoothing : t.gpuMs;
+            t.cpuAverage = t.samples ? t.cpuAverage + (t.cpuMs - t.cpuAverage) * smoothing : t.cpuMs;
+            t.samples++;
+            t.gpuTotal += t.gpuMs;
+            t.cpuTotal += t.cpuMs;
+            if (!log) continue;
+            char gpuMs[32];
+            std::snprintf(gpuMs, sizeof(gpuMs), "%.4f", t.gpuMs);
+            if (json)
+                std::fprintf(log, "%s  {\"frame\": %llu, \"pass\": \"%s\", \"gpu_ms\": %s, \"cpu_ms\": %.4f}",
+                             logRows ? ",\n" : "", static_cast<unsigned long long>(s.frame), t.name.c_str(),
+                             t.gpu ? gpuMs : "null", t.cpuMs);
+            else
+                std::fprintf(log, "%llu,%s,%s,%.4f\n", static_cast<unsigned long long>(s.frame), t.name.c_str(),
+                             t.gpu ? gpuMs : "", t.cpuMs);
+            logRows++;
+        }
+    }
+};
+
+#endif
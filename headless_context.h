@@ -0,0 +1,254 @@
+#ifndef HEADLESS_CONTEXT_H
+#define HEADLESS_CONTEXT_H
+
+#include <glad/glad.h>
+
+#if defined(HEADLESS_EGL)
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#endif
+#if defined(HEADLESS_OSMESA)
+#include <GL/osmesa.h>
+#endif
+
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// GL 3.3 core context without a window or display, for render / CI nodes.
+// Backends are picked at compile time and tried in this order:
+//   HEADLESS_EGL     EGL with the Mesa surfaceless platform (link -lEGL)
+//   HEADLESS_OSMESA  Mesa's off-screen renderer (link -lOSMesa)
+// Both run on llvmpipe when there is no GPU. Nothing is ever presented, so
+// the frame goes into an OffscreenTarget instead of a default framebuffer.
+
+#if defined(HEADLESS_EGL)
+#ifndef EGL_PLATFORM_SURFACELESS_MESA
+#define EGL_PLATFORM_SURFACELESS_MESA 0x31DD
+#endif
+#ifndef EGL_CONTEXT_MAJOR_VERSION
+#define EGL_CONTEXT_MAJOR_VERSION 0x3098
+#define EGL_CONTEXT_MINOR_VERSION 0x30FB
+#define EGL_CONTEXT_OPENGL_PROFILE_MASK 0x30FD
+#define EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT 0x00000001
+#endif
+#endif
+
+class HeadlessContext {
+public:
+    HeadlessContext() = default;
+    HeadlessContext(const HeadlessContext&) = delete;
+    HeadlessContext& operator=(const HeadlessContext&) = delete;
+    ~HeadlessContext() { destroy(); }
+
+    // make a context current; width / height only size OSMesa's (unused) color buffer
+    bool create(int width, int height)
+    {
+#if defined(HEADLESS_EGL)
+        if (createEgl()) return true;
+#endif
+#if defined(HEADLESS_OSMESA)
+        if (createOsMesa(width, height)) return true;
+#endif
+        (void)width;
+        (void)height;
+#if !defined(HEADLESS_EGL) && !defined(HEADLESS_OSMESA)
+        std::cerr << "Headless: built without HEADLESS_EGL or HEADLESS_OSMESA" << std::endl;
+#endif
+        return false;
+    }
+
+    // for gladLoadGLLoader / IndirectDrawApi::load
+    static void* getProcAddress(const char* name)
+    {
+#if defined(HEADLESS_EGL)
+        if (activeBackend() == Backend::Egl) return reinterpret_cast<void*>(eglGetProcAddress(name));
+#endif
+#if defined(HEADLESS_OSMESA)
+        if (activeBackend() == Backend::OsMesa) return reinterpret_cast<void*>(OSMesaGetProcAddress(name));
+#endif
+        (void)name;
+        return nullptr;
+    }
+
+    const char* backendName() const
+    {
+        switch (activeBackend()) {
+        case Backend::Egl: return "EGL surfaceless";
+        case Backend::OsMesa: return "OSMesa";
+        default: return "none";
+        }
+    }
+
+    void destroy()
+    {
+#if defined(HEADLESS_EGL)
+        if (eglDisplay != EGL_NO_DISPLAY) {
+            eglMakeCurrent(eglDisplay, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+            if (eglCtx != EGL_NO_CONTEXT) eglDestroyContext(eglDisplay, eglCtx);
+            eglTerminate(eglDisplay);
+            eglDisplay = EGL_NO_DISPLAY;
+            eglCtx = EGL_NO_CONTEXT;
+        }
+#endif
+#if defined(HEADLESS_OSMESA)
+        if (osCtx) {
+            OSMesaDestroyContext(osCtx);
+            osCtx = nullptr;
+        }
+        osBuffer.clear();
+#endif
+        activeBackend() = Backend::None;
+    }
+
+private:
+    enum class Backend { None, Egl, OsMesa };
+
+    // the loader callback is a plain function, so the live backend is process-wide
+    static Backend& activeBackend()
+    {
+        static Backend backend = Backend::None;
+        return backend;
+    }
+
+#if defined(HEADLESS_EGL)
+    EGLDisplay eglDisplay = EGL_NO_DISPLAY;
+    EGLContext eglCtx = EGL_NO_CONTEXT;
+
+    bool createEgl()
+    {
+        typedef EGLDisplay (EGLAPIENTRYP GetPlatformDisplayFn)(EGLenum platform, void* nativeDisplay, const EGLint* attribs);
+        const char* clientExts = eglQueryString(EGL_NO_DISPLAY, EGL_EXTENSIONS);
+        GetPlatformDisplayFn getPlatformDisplay =
+            (GetPlatformDisplayFn)eglGetProcAddress("eglGetPlatformDisplayEXT");
+        if (getPlatformDisplay && clientExts && std::strstr(clientExts, "EGL_MESA_platform_surfaceless"))
+            eglDisplay = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+        if (eglDisplay == EGL_NO_DISPLAY) eglDisplay = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+        if (eglDisplay == EGL_NO_DISPLAY || !eglInitialize(eglDisplay, nullptr, nullptr)) {
+            std::cerr << "Headless: no EGL display" << std::endl;
+            eglDisplay = EGL_NO_DISPLAY;
+            return false;
+        }
+        const char* exts = eglQueryString(eglDisplay, EGL_EXTENSIONS);
+        if (!exts || !std::strstr(exts, "EGL_KHR_surfaceless_context")) {
+            std::cerr << "Headless: EGL display has no surfaceless contexts" << std::endl;
+            destroy();
+            return false;
+        }
+
+        const EGLint configAttribs[] = { EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT, EGL_NONE };
+        EGLConfig config = nullptr;
+        EGLint configCount = 0;
+        eglChooseConfig(eglDisplay, configAttribs, &config, 1, &configCount);
+        if (configCount == 0 && !std::strstr(exts, "EGL_KHR_no_config_context")) {
+            std::cerr << "Headless: no EGL config for desktop GL" << std::endl;
+            destroy();
+            return false;
+        }
+
+        const EGLint contextAttribs[] = { EGL_CONTEXT_MAJOR_VERSION, 3, EGL_CONTEXT_MINOR_VERSION, 3,
+                                          EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT, EGL_NONE };
+        eglBindAPI(EGL_OPENGL_API);
+        eglCtx = eglCreateContext(eglDisplay, configCount ? config : (EGLConfig)nullptr, EGL_NO_CONTEXT, contextAttribs);
+        if (eglCtx == EGL_NO_CONTEXT || !eglMakeCurrent(eglDisplay, EGL_NO_SURFACE, EGL_NO_SURFACE, eglCtx)) {
+            std::cerr << "Headless: can't create a GL 3.3 core EGL context" << std::endl;
+            destroy();
+            return false;
+        }
+        activeBackend() = Backend::Egl;
+        return true;
+    }
+#endif
+
+#if defined(HEADLESS_OSMESA)
+    OSMesaContext osCtx = nullptr;
+    std::vector<unsigned char> osBuffer;
+
+    bool createOsMesa(int width, int height)
+    {
+        const int attribs[] = { OSMESA_FORMAT, OSMESA_RGBA, OSMESA_DEPTH_BITS, 24,
+                                OSMESA_PROFILE, OSMESA_CORE_PROFILE, OSMESA_CONTEXT_MAJOR_VERSION, 3,
+                                OSMESA_CONTEXT_MINOR_VERSION, 3, 0 };
+        osCtx = OSMesaCreateContextAttribs(attribs, nullptr);
+        if (!osCtx) {
+            std::cerr << "Headless: can't create a GL 3.3 core OSMesa context" << std::endl;
+            return false;
+        }
+        osBuffer.assign(static_cast<size_t>(width) * height * 4, 0);
+        if (!OSMesaMakeCurrent(osCtx, osBuffer.data(), GL_UNSIGNED_BYTE, width, height)) {
+            std::cerr << "Headless: OSMesaMakeCurrent failed" << std::endl;
+            destroy();
+            return false;
+        }
+        activeBackend() = Backend::OsMesa;
+        return true;
+    }
+#endif
+};
+
+// Color + depth renderbuffers the headless frames are drawn into.
+class OffscreenTarget {
+public:
+    bool create(int w, int h)
+    {
+        release();
+        width = w;
+        height = h;
+        glGenFramebuffers(1, &fbo);
+        glGenRenderbuffers(1, &color);
+        glGenRenderbuffers(1, &depth);
+        glBindRenderbuffer(GL_RENDERBUFFER, color);
+        glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, w, h);
+        glBindRenderbuffer(GL_RENDERBUFFER, depth);
+        glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, w, h);
+        glBindRenderbuffer(GL_RENDERBUFFER, 0);
+        glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, color);
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, depth);
+        bool complete = glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        if (!complete) {
+            std::cerr << "Headless: offscreen framebuffer incomplete" << std::endl;
+            release();
+        }
+        return complete;
+    }
+
+    void bind() const
+    {
+        glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+        glViewport(0, 0, width, height);
+    }
+
+    // current color buffer as a binary PPM, flipped to top-down rows
+    bool writePPM(const std::string& path) const
+    {
+        std::vector<unsigned char> pixels(static_cast<size_t>(width) * height * 4);
+        glBindFramebuffer(GL_READ_FRAMEBUFFER, fbo);
+        glPixelStorei(GL_PACK_ALIGNMENT, 1);
+        glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+        FILE* f = std::fopen(path.c_str(), "wb");
+        if (!f) return false;
+        std::fprintf(f, "P6\n%d %d\n255\n", width, height);
+        for (int y = height - 1; y >= 0; y--)
+            for (int x = 0; x < width; x++) std::fwrite(&pixels[(static_cast<size_t>(y) * width + x) * 4], 1, 3, f);
+        return std::fclose(f) == 0;
+    }
+
+    void release()
+    {
+        if (fbo) glDeleteFramebuffers(1, &fbo);
+        if (color) glDeleteRenderbuffers(1, &color);
+        if (depth) glDeleteRenderbuffers(1, &depth);
+        fbo = color = depth = 0;
+    }
+
+    int width = 0, height = 0;
+
+private:
+    GLuint fbo = 0, color = 0, depth = 0;
+};
+
+#endif
@@ -0,0 +1,182 @@
+#ifndef INDIRECT_DRAW_H
+#define INDIRECT_DRAW_H
+
+#include <glad/glad.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+// Multi-draw-indirect (GL 4.3) with persistently mapped command buffers (GL 4.4
+// or ARB_buffer_storage). glad here is generated for 3.3 core, so the entry
+// points are fetched at runtime and the few enums are defined if missing; on
+// older contexts available() is false and callers keep their direct draws.
+
+#ifndef GL_DRAW_INDIRECT_BUFFER
+#define GL_DRAW_INDIRECT_BUFFER 0x8F3F
+#endif
+#ifndef GL_MAP_PERSISTENT_BIT
+#define GL_MAP_PERSISTENT_BIT 0x0040
+#endif
+#ifndef GL_MAP_COHERENT_BIT
+#define GL_MAP_COHERENT_BIT 0x0080
+#endif
+
+// record layouts fixed by the GL spec
+struct DrawArraysIndirectCommand {
+    GLuint count;
+    GLuint instanceCount;
+    GLuint first;
+    GLuint baseInstance;
+};
+
+struct DrawElementsIndirectCommand {
+    GLuint count;
+    GLuint instanceCount;
+    GLuint firstIndex;
+    GLint baseVertex;
+    GLuint baseInstance;
+};
+
+struct IndirectDrawApi {
+    typedef void (APIENTRYP MultiDrawArraysIndirectFn)(GLenum mode, const void* indirect, GLsizei drawcount, GLsizei stride);
+    typedef void (APIENTRYP MultiDrawElementsIndirectFn)(GLenum mode, GLenum type, const void* indirect, GLsizei drawcount,
+                                                         GLsizei stride);
+    typedef void (APIENTRYP BufferStorageFn)(GLenum target, GLsizeiptr size, const void* data, GLbitfield flags);
+
+    MultiDrawArraysIndirectFn multiDrawArraysIndirect = nullptr;
+    MultiDrawElementsIndirectFn multiDrawElementsIndirect = nullptr;
+    BufferStorageFn bufferStorage = nullptr; // null without persistent mapping support
+    GLint major = 0, minor = 0;
+
+    // needs a current context; pass the same loader glad got
+    bool load(GLADloadproc getProc)
+    {
+        glGetIntegerv(GL_MAJOR_VERSION, &major);
+        glGetIntegerv(GL_MINOR_VERSION, &minor);
+        int version = major * 10 + minor;
+        if (version >= 43 || (version >= 40 && hasExtension("GL_ARB_multi_draw_indirect"))) {
+            multiDrawArraysIndirect = (MultiDrawArraysIndirectFn)getProc("glMultiDrawArraysIndirect");
+            multiDrawElementsIndirect = (MultiDrawElementsIndirectFn)getProc("glMultiDrawElementsIndirect");
+        }
+        if (version >= 44 || hasExtension("GL_ARB_buffer_storage"))
+            bufferStorage = (BufferStorageFn)getProc("glBufferStorage");
+        return available();
+    }
+
+    bool available() const { return multiDrawArraysIndirect && multiDrawElementsIndirect; }
+    bool persistent() const { return bufferStorage != nullptr; }
+
+    static bool hasExtension(const char* name)
+    {
+        GLint count = 0;
+        glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+        for (GLint i = 0; i < count; i++) {
+            const char* ext = reinterpret_cast<const char*>(glGetStringi(GL_EXTENSIONS, static_cast<GLuint>(i)));
+            if (ext && std::strcmp(ext, name) == 0) return true;
+        }
+        return false;
+    }
+};
+
+// Per-frame draw commands in one GL_DRAW_INDIRECT_BUFFER split into FRAMES
+// regions. With persistent mapping, commands are written straight into the
+// mapped region and a fence per region keeps the CPU from overwriting commands
+// the GPU has not consumed yet. Without it the region is filled with
+// glBufferSubData at each write. A region holds bytesPerFrame, so size it for
+// the worst frame; write() returns false once a frame runs out.
+class IndirectCommandBuffer {
+public:
+    static const int FRAMES = 3;
+
+    void create(const IndirectDrawApi& api, size_t bytesPerFrame)
+    {
+        release();
+        this->api = &api;
+        regionSize = (bytesPerFrame + 255) & ~static_cast<size_t>(255);
+        glGenBuffers(1, &buffer);
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, buffer);
+        GLsizeiptr total = static_cast<GLsizeiptr>(regionSize * FRAMES);
+        if (api.persistent()) {
+            GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+            api.bufferStorage(GL_DRAW_INDIRECT_BUFFER, total, nullptr, flags);
+            mapped = static_cast<unsigned char*>(glMapBufferRange(GL_DRAW_INDIRECT_BUFFER, 0, total, flags));
+        }
+        else {
+            glBufferData(GL_DRAW_INDIRECT_BUFFER, total, nullptr, GL_STREAM_DRAW);
+        }
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+    }
+
+    // move to the next region, waiting until the GPU is done with it
+    void beginFrame()
+    {
+        region = (region + 1) % FRAMES;
+        offset = 0;
+        if (fences[region]) {
+            while (true) {
+                GLenum r = glClientWaitSync(fences[region], GL_SYNC_FLUSH_COMMANDS_BIT, 1000000); // 1 ms
+                if (r == GL_ALREADY_SIGNALED || r == GL_CONDITION_SATISFIED || r == GL_WAIT_FAILED) break;
+            }
+            glDeleteSync(fences[region]);
+            fences[region] = 0;
+        }
+    }
+
+    // append count commands to this frame; indirect gets the offset to draw from
+    // (with this buffer bound to GL_DRAW_INDIRECT_BUFFER)
+    template <typename Command>
+    bool write(const Command* commands, size_t count, const void*& indirect)
+    {
+        size_t bytes = count * sizeof(Command);
+        if (!buffer || offset + bytes > regionSize) return false;
+        size_t at = region * regionSize + offset;
+        if (mapped) {
+            std::memcpy(mapped + at, commands, bytes);
+        }
+        else {
+            glBindBuffer(GL_DRAW_INDIRECT_BUFFER, buffer);
+            glBufferSubData(GL_DRAW_INDIRECT_BUFFER, static_cast<GLintptr>(at), static_cast<GLsizeiptr>(bytes), commands);
+        }
+        indirect = reinterpret_cast<const void*>(at);
+        offset += bytes;
+        return true;
+    }
+
+    // after the frame's last indirect draw
+    void endFrame()
+    {
+        if (buffer) fences[region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    }
+
+    void bind() const { glBindBuffer(GL_DRAW_INDIRECT_BUFFER, buffer); }
+    const IndirectDrawApi& functions() const { return *api; }
+
+    void release()
+    {
+        if (!buffer) return;
+        for (GLsync& f : fences) {
+            if (f) glDeleteSync(f);
+            f = 0;
+        }
+        if (mapped) {
+            glBindBuffer(GL_DRAW_INDIRECT_BUFFER, buffer);
+            glUnmapBuffer(GL_DRAW_INDIRECT_BUFFER);
+            glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+        }
+        glDeleteBuffers(1, &buffer);
+        buffer = 0;
+        mapped = nullptr;
+    }
+
+private:
+    const IndirectDrawApi* api = nullptr;
+    GLuint buffer = 0;
+    unsigned char* mapped = nullptr;
+    size_t regionSize = 0;
+    size_t offset = 0;
+    int region = 0;
+    GLsync fences[FRAMES] = {};
+};
+
+#endif
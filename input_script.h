@@ -0,0 +1,146 @@
+#ifndef INPUT_SCRIPT_H
+#define INPUT_SCRIPT_H
+
+#include <GLFW/glfw3.h>
+
+#include <algorithm>
+#include <cctype>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// Frame-indexed keyboard / mouse input for runs without a window (headless
+// mode). One command per line, frames count from 0, '#' starts a comment:
+//
+//   hold   <first> <last> <key>       key down for frames first..last
+//   press  <frame> <key>              key down for that one frame
+//   mouse  <first> <last> <dx> <dy>   cursor moves by dx, dy pixels every frame
+//   scroll <frame> <amount>           wheel step on that frame
+//   end    <frame>                    run length (default: one past the last command)
+//
+// Keys are GLFW names without the prefix: W, A, S, D, 1..4, C, P, SPACE, ESCAPE, ...
+class InputScript {
+public:
+    bool load(const std::string& path)
+    {
+        std::ifstream in(path);
+        if (!in) {
+            std::cerr << "Input script: cannot open " << path << std::endl;
+            return false;
+        }
+        holds.clear();
+        moves.clear();
+        scrolls.clear();
+        frames = 0;
+        int explicitEnd = -1;
+        std::string line;
+        for (int lineNo = 1; std::getline(in, line); lineNo++) {
+            size_t hash = line.find('#');
+            if (hash != std::string::npos) line.erase(hash);
+            std::istringstream words(line);
+            std::string command;
+            if (!(words >> command)) continue;
+            bool ok = false;
+            if (command == "hold" || command == "press") {
+                Hold h;
+                std::string key;
+                ok = static_cast<bool>(words >> h.first);
+                if (ok && command == "hold") ok = static_cast<bool>(words >> h.last);
+                else h.last = h.first;
+                ok = ok && (words >> key) && (h.key = keyCode(key)) != GLFW_KEY_UNKNOWN;
+                if (ok) {
+                    holds.push_back(h);
+                    frames = std::max(frames, h.last + 1);
+                }
+            }
+            else if (command == "mouse") {
+                Move m;
+                ok = static_cast<bool>(words >> m.first >> m.last >> m.dx >> m.dy);
+                if (ok) {
+                    moves.push_back(m);
+                    frames = std::max(frames, m.last + 1);
+                }
+            }
+            else if (command == "scroll") {
+                Scroll s;
+                ok = static_cast<bool>(words >> s.frame >> s.amount);
+                if (ok) {
+                    scrolls.push_back(s);
+                    frames = std::max(frames, s.frame + 1);
+                }
+            }
+            else if (command == "end") {
+                ok = static_cast<bool>(words >> explicitEnd);
+            }
+            if (!ok) {
+                std::cerr << "Input script " << path << ":" << lineNo << ": can't parse '" << line << "'" << std::endl;
+                return false;
+            }
+        }
+        if (explicitEnd >= 0) frames = explicitEnd;
+        return true;
+    }
+
+    bool keyDown(int frame, int key) const
+    {
+        for (const Hold& h : holds)
+            if (h.key == key && frame >= h.first && frame <= h.last) return true;
+        return false;
+    }
+
+    // cursor movement and wheel steps for this frame
+    void mouseDelta(int frame, float& dx, float& dy) const
+    {
+        dx = dy = 0.0f;
+        for (const Move& m : moves) {
+            if (frame < m.first || frame > m.last) continue;
+            dx += m.dx;
+            dy += m.dy;
+        }
+    }
+    float scroll(int frame) const
+    {
+        float amount = 0.0f;
+        for (const Scroll& s : scrolls)
+            if (s.frame == frame) amount += s.amount;
+        return amount;
+    }
+
+    int frameCount() const { return frames; }
+
+    // GLFW key code for a name like "W", "3" or "SPACE"; GLFW_KEY_UNKNOWN if unknown
+    static int keyCode(std::string name)
+    {
+        for (char& c : name) c = static_cast<char>(std::toupper(static_cast<unsigned char>(c)));
+        if (name.size() == 1 && name[0] >= 'A' && name[0] <= 'Z') return GLFW_KEY_A + (name[0] - 'A');
+        if (name.size() == 1 && name[0] >= '0' && name[0] <= '9') return GLFW_KEY_0 + (name[0] - '0');
+        if (name == "SPACE") return GLFW_KEY_SPACE;
+        if (name == "ESCAPE") return GLFW_KEY_ESCAPE;
+        if (name == "ENTER") return GLFW_KEY_ENTER;
+        if (name == "LEFT_SHIFT") return GLFW_KEY_LEFT_SHIFT;
+        return GLFW_KEY_UNKNOWN;
+    }
+
+private:
+    struct Hold {
+        int first = 0, last = 0;
+        int key = GLFW_KEY_UNKNOWN;
+    };
+    struct Move {
+        int first = 0, last = 0;
+        float dx = 0.0f, dy = 0.0f;
+    };
+    struct Scroll {
+        int frame = 0;
+        float amount = 0.0f;
+    };
+
+    std::vector<Hold> holds;
+    std::vector<Move> moves;
+    std::vector<Scroll> scrolls;
+    int frames = 0;
+};
+
+#endif
@@ -0,0 +1,259 @@
+#ifndef MAZE_PVS_H
+#define MAZE_PVS_H
+
+#include <glm/glm.hpp>
+
+#include "collision.h"
+#include "obstacle_bvh.h"
+#include "worker_pool.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Potentially visible sets for the static maze, built once at load time.
+// The level is split into square XZ cells. Eye points sit on a lattice over the
+// cells (every cell corner, or a finer grid, at a few heights); each eye finds
+// the boxes it can see, and a cell's set is the union over the eyes on its
+// boundary and inside it, so neighbouring cells share the eyes on their edges.
+// Box ids follow the draw order: platforms first, then obstacles (same as
+// StaticMazeMesh).
+//
+// Eye-to-face visibility works on corners: the segments from an eye to a face
+// rectangle fill a pyramid, and a convex obstacle crossed by all four corner
+// segments crosses every segment inside it, so the face is hidden. Otherwise the
+// rectangle is split in two and each half tested again, down to targetSpacing.
+// Obstacle BVH subtrees are rejected the same way through their bounds.
+//
+// Visibility is sampled at the eyes, so a sliver seen only from between two
+// eyes can be missed. A set only holds for eyes inside the height band it was
+// built for: above the walls, outside the grid, or in a cell whose eyes are all
+// inside walls there is no set and the caller draws as if there were no PVS.
+
+struct PvsSettings {
+    float cellSize = 2.0f;       // XZ cell edge
+    int eyeSubdivisions = 1;     // eye lattice steps per cell edge (1 = corners only)
+    float eyeMinY = 0.2f;        // eye heights the sets are valid for
+    float eyeMaxY = 2.0f;
+    int eyeLevels = 3;           // heights sampled across the band
+    float targetSpacing = 1.0f;  // smallest face piece
+    float viewDistance = 100.0f; // boxes further than this (on any axis) are never in a set
+};
+
+class MazePVS {
+public:
+    // occluders must be a BVH over obstacles (the collision world's)
+    void build(const std::vector<Box>& platforms, const std::vector<Box>& obstacles, const ObstacleBVH& occluders,
+               const PvsSettings& settings, WorkerPool* pool = nullptr)
+    {
+        config = settings;
+        config.eyeSubdivisions = std::max(1, config.eyeSubdivisions);
+        config.eyeLevels = std::max(1, config.eyeLevels);
+        nx = nz = 0;
+        cellStart.clear();
+        cellBoxes.clear();
+        solidCells.clear();
+        if (platforms.empty() && obstacles.empty()) return;
+
+        Box level = emptyBox();
+        for (const Box& b : platforms) growBox(level, b);
+        for (const Box& b : obstacles) growBox(level, b);
+        originX = level.min.x;
+        originZ = level.min.z;
+        nx = std::max(1, static_cast<int>(std::ceil((level.max.x - level.min.x) / config.cellSize)));
+        nz = std::max(1, static_cast<int>(std::ceil((level.max.z - level.min.z) / config.cellSize)));
+
+        // what every lattice eye sees
+        int k = config.eyeSubdivisions;
+        int ex = nx * k + 1, ez = nz * k + 1;
+        size_t eyeCount = static_cast<size_t>(ex) * ez * config.eyeLevels;
+        std::vector<std::vector<uint32_t>> eyeSets(eyeCount);
+        std::vector<uint8_t> eyeValid(eyeCount, 0);
+        auto runEyes = [&](size_t begin, size_t end) {
+            std::vector<uint32_t> candidates;
+            for (size_t e = begin; e < end; e++) {
+                size_t column = e % (static_cast<size_t>(ex) * ez);
+                int level = static_cast<int>(e / (static_cast<size_t>(ex) * ez));
+                float t = config.eyeLevels > 1 ? static_cast<float>(level) / (config.eyeLevels - 1) : 0.5f;
+                glm::vec3 eye(originX + (column % ex) * config.cellSize / k, config.eyeMinY + (config.eyeMaxY - config.eyeMinY) * t,
+                              originZ + (column / ex) * config.cellSize / k);
+                if (occluders.segmentBlocked(eye, glm::vec3(0.0f))) continue; // inside a wall
+                eyeValid[e] = 1;
+                visibleFromEye(eye, platforms, obstacles, occluders, candidates, eyeSets[e]);
+            }
+        };
+        if (pool) pool->parallelFor(eyeCount, 4, runEyes);
+        else runEyes(0, eyeCount);
+
+        // cell sets: union over the cell's eyes
+        size_t cells = static_cast<size_t>(nx) * nz;
+        size_t boxCount = platforms.size() + obstacles.size();
+        std::vector<std::vector<uint32_t>> sets(cells);
+        solidCells.assign(cells, 0);
+        auto runCells = [&](size_t begin, size_t end) {
+            std::vector<uint8_t> seen(boxCount, 0);
+            for (size_t c = begin; c < end; c++) {
+                int cx = static_cast<int>(c % nx) * k, cz = static_cast<int>(c / nx) * k;
+                bool anyEye = false;
+                for (int level = 0; level < config.eyeLevels; level++) {
+                    for (int z = cz; z <= cz + k; z++) {
+                        for (int x = cx; x <= cx + k; x++) {
+                            size_t e = (static_cast<size_t>(level) * ez + z) * ex + x;
+                            anyEye |= eyeValid[e] != 0;
+                            for (uint32_t id : eyeSets[e]) {
+                                if (seen[id]) continue;
+                                seen[id] = 1;
+                                sets[c].push_back(id);
+                            }
+                        }
+                    }
+                }
+                for (uint32_t id : sets[c]) seen[id] = 0;
+                std::sort(sets[c].begin(), sets[c].end());
+                solidCells[c] = anyEye ? 0 : 1;
+            }
+        };
+        if (pool) pool->parallelFor(cells, 16, runCells);
+        else runCells(0, cells);
+
+        // flatten into one array, cell c owns [cellStart[c], cellStart[c + 1])
+        cellStart.resize(cells + 1);
+        cellStart[0] = 0;
+        for (size_t c = 0; c < cells; c++) cellStart[c + 1] = cellStart[c] + static_cast<uint32_t>(sets[c].size());
+        cellBoxes.reserve(cellStart[cells]);
+        for (const std::vector<uint32_t>& s : sets) cellBoxes.insert(cellBoxes.end(), s.begin(), s.end());
+    }
+
+    // sorted ids of the boxes visible from eye's cell; false if there is no set for eye
+    bool visibleFrom(const glm::vec3& eye, const uint32_t*& boxes, size_t& count) const
+    {
+        count = 0;
+        if (cellStart.empty() || eye.y < config.eyeMinY || eye.y > config.eyeMaxY) return false;
+        int x = static_cast<int>(std::floor((eye.x - originX) / config.cellSize));
+        int z = static_cast<int>(std::floor((eye.z - originZ) / config.cellSize));
+        if (x < 0 || z < 0 || x >= nx || z >= nz) return false;
+        size_t c = static_cast<size_t>(z) * nx + x;
+        if (solidCells[c]) return false;
+        boxes = cellBoxes.data() + cellStart[c];
+        count = cellStart[c + 1] - cellStart[c];
+        return true;
+    }
+
+    size_t cellCount() const { return solidCells.size(); }
+
+    // mean set size over the cells that have one
+    float averageSetSize() const
+    {
+        size_t open = 0;
+        for (uint8_t s : solidCells) open += s ? 0 : 1;
+        return open ? static_cast<float>(cellBoxes.size()) / open : 0.0f;
+    }
+
+private:
+    static constexpr float TARGET_PUSH = 2e-3f; // face corners sit just outside the face
+
+    // axis-aligned rectangle on the plane axis = plane; lo/hi are the other two axes in order
+    struct FaceRect {
+        int axis;
+        float plane;
+        glm::vec2 lo, hi;
+    };
+
+    PvsSettings config;
+    float originX = 0.0f, originZ = 0.0f;
+    int nx = 0, nz = 0;
+    std::vector<uint32_t> cellStart;
+    std::vector<uint32_t> cellBoxes;
+    std::vector<uint8_t> solidCells; // every eye of the cell is inside a wall
+
+    void visibleFromEye(const glm::vec3& eye, const std::vector<Box>& platforms, const std::vector<Box>& obstacles,
+                        const ObstacleBVH& occluders, std::vector<uint32_t>& candidates, std::vector<uint32_t>& out) const
+    {
+        Box range = { eye - glm::vec3(config.viewDistance), eye + glm::vec3(config.viewDistance) };
+        for (uint32_t i = 0; i < platforms.size(); i++)
+            if (boxesOverlap(range, platforms[i]) && eyeSeesBox(eye, platforms[i], obstacles, occluders)) out.push_back(i);
+
+        // obstacles: walk the BVH and drop every subtree whose bounds the eye can't see.
+        // Segments to a face from in front of it never enter the box, so only what
+        // is outside the node can block them.
+        candidates.clear();
+        const std::vector<ObstacleBVH::Node>& nodes = occluders.getNodes();
+        if (!nodes.empty()) {
+            uint32_t stack[64];
+            int sp = 0;
+            stack[sp++] = 0;
+            while (sp > 0) {
+                const ObstacleBVH::Node& n = nodes[stack[--sp]];
+                if (!boxesOverlap(range, n.bounds)) continue;
+                if (!boxContains(n.bounds, eye) && !eyeSeesBox(eye, n.bounds, obstacles, occluders)) continue;
+                if (n.count > 0) {
+                    for (uint32_t i = 0; i < n.count; i++) candidates.push_back(occluders.leafId(n.leftOrFirst + i));
+                }
+                else {
+                    stack[sp++] = n.leftOrFirst;
+                    stack[sp++] = n.leftOrFirst + 1;
+                }
+            }
+        }
+        std::sort(candidates.begin(), candidates.end());
+        uint32_t firstObstacle = static_cast<uint32_t>(platforms.size());
+        for (uint32_t id : candidates)
+            if (boxesOverlap(range, obstacles[id]) && eyeSeesBox(eye, obstacles[id], obstacles, occluders))
+                out.push_back(firstObstacle + id);
+    }
+
+    static bool boxContains(const Box& b, const glm::vec3& p)
+    {
+        return p.x >= b.min.x && p.x <= b.max.x && p.y >= b.min.y && p.y <= b.max.y && p.z >= b.min.z && p.z <= b.max.z;
+    }
+
+    // any face of b turned towards the eye
+    bool eyeSeesBox(const glm::vec3& eye, const Box& b, const std::vector<Box>& obstacles, const ObstacleBVH& occluders) const
+    {
+        for (int axis = 0; axis < 3; axis++) {
+            for (int side = 0; side < 2; side++) {
+                float plane = side ? b.max[axis] : b.min[axis];
+                if (side ? eye[axis] <= plane : eye[axis] >= plane) continue; // back face
+                FaceRect r;
+                r.axis = axis;
+                r.plane = side ? plane + TARGET_PUSH : plane - TARGET_PUSH;
+                r.lo = glm::vec2(b.min[(axis + 1) % 3], b.min[(axis + 2) % 3]);
+                r.hi = glm::vec2(b.max[(axis + 1) % 3], b.max[(axis + 2) % 3]);
+                if (eyeSeesRect(eye, r, obstacles, occluders)) return true;
+            }
+        }
+        return false;
+    }
+
+    bool eyeSeesRect(const glm::vec3& eye, const FaceRect& r, const std::vector<Box>& obstacles, const ObstacleBVH& occluders) const
+    {
+        glm::vec3 corners[4];
+        for (int k = 0; k < 4; k++) {
+            corners[k][r.axis] = r.plane;
+            corners[k][(r.axis + 1) % 3] = (k & 1) ? r.hi.x : r.lo.x;
+            corners[k][(r.axis + 2) % 3] = (k & 2) ? r.hi.y : r.lo.y;
+        }
+        uint32_t blockers[4];
+        for (int k = 0; k < 4; k++)
+            if (!occluders.segmentBlocked(eye, corners[k] - eye, &blockers[k])) return true; // clear line of sight
+        bool covered = true;
+        for (int k = 1; k < 4 && covered; k++)
+            covered = blockers[k] == blockers[0] ||
+                      segmentCrossesAABBInside(eye, corners[k] - eye, obstacles[blockers[0]], ObstacleBVH::INSIDE_EPSILON);
+        if (covered) return false;
+
+        // split the longer side in half, down to targetSpacing
+        glm::vec2 size = r.hi - r.lo;
+        int a = size.x >= size.y ? 0 : 1;
+        if (size[a] <= config.targetSpacing) return false;
+        float mid = (r.lo[a] + r.hi[a]) * 0.5f;
+        FaceRect first = r, second = r;
+        first.hi[a] = mid;
+        second.lo[a] = mid;
+        return eyeSeesRect(eye, first, obstacles, occluders) || eyeSeesRect(eye, second, obstacles, occluders);
+    }
+};
+
+#endif
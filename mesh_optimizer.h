@@ -0,0 +1,269 @@
+#ifndef MESH_OPTIMIZER_H
+#define MESH_OPTIMIZER_H
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <unordered_map>
+#include <vector>
+
+// Import-time reordering of an indexed triangle mesh, in three passes (after
+// welding: importers like Assimp's OBJ reader emit one vertex per face corner,
+// and with every index unique there is nothing for the passes to reuse):
+//  1. vertex cache: Tipsify (Sander, Nehab, Barczak 2007), a linear-time
+//     greedy fan walk tuned for a FIFO post-transform cache of cacheSize
+//  2. overdraw: the walk's clusters are split further wherever that costs
+//     little cache efficiency (at most threshold x the cluster's ACMR), then
+//     sorted so the clusters facing away from the mesh center come first;
+//     outer surfaces draw first and hide what's behind them
+//  3. vertex fetch: vertices renumbered in first-use order, unused ones dropped
+// Triangle winding is kept. Indices are uint32_t, relative to the mesh's first
+// vertex; positions are read through a byte stride so any vertex struct works.
+
+const unsigned int VERTEX_CACHE_SIZE = 16;
+
+// byte-identical vertices merged: remap[v] = first vertex equal to v; returns
+// how many vertices are distinct
+inline size_t weldVertices(const void* vertices, size_t stride, size_t vertexCount, std::vector<uint32_t>& remap)
+{
+    const unsigned char* bytes = static_cast<const unsigned char*>(vertices);
+    struct Hash {
+        const unsigned char* bytes;
+        size_t stride;
+        size_t operator()(uint32_t v) const
+        {
+            size_t h = 14695981039346656037ull; // FNV-1a
+            for (size_t i = 0; i < stride; i++) h = (h ^ bytes[v * stride + i]) * 1099511628211ull;
+            return h;
+        }
+    };
+    struct Equal {
+        const unsigned char* bytes;
+        size_t stride;
+        bool operator()(uint32_t a, uint32_t b) const { return std::memcmp(bytes + a * stride, bytes + b * stride, stride) == 0; }
+    };
+    std::unordered_map<uint32_t, uint32_t, Hash, Equal> first(vertexCount, Hash{ bytes, stride }, Equal{ bytes, stride });
+    remap.resize(vertexCount);
+    size_t distinct = 0;
+    for (uint32_t v = 0; v < vertexCount; v++) {
+        auto inserted = first.emplace(v, v);
+        remap[v] = inserted.first->second;
+        if (inserted.second) distinct++;
+    }
+    return distinct;
+}
+
+// FIFO cache simulation: acmr = misses per triangle (0.5 ideal, 3 worst),
+// atvr = misses per referenced vertex (1 ideal)
+struct VertexCacheStats {
+    size_t triangles = 0, vertices = 0, misses = 0;
+
+    double acmr() const { return triangles ? double(misses) / triangles : 0.0; }
+    double atvr() const { return vertices ? double(misses) / vertices : 0.0; }
+
+    VertexCacheStats& operator+=(const VertexCacheStats& o)
+    {
+        triangles += o.triangles;
+        vertices += o.vertices;
+        misses += o.misses;
+        return *this;
+    }
+};
+
+inline VertexCacheStats analyzeVertexCache(const uint32_t* indices, size_t indexCount, size_t vertexCount,
+                                           unsigned int cacheSize = VERTEX_CACHE_SIZE)
+{
+    VertexCacheStats stats;
+    std::vector<uint32_t> stamp(vertexCount, 0); // time the vertex entered the cache, 0 = never
+    uint32_t time = cacheSize + 1;
+    for (size_t i = 0; i < indexCount; i++) {
+        uint32_t v = indices[i];
+        if (!stamp[v]) stats.vertices++;
+        if (time - stamp[v] > cacheSize) {
+            stamp[v] = time++;
+            stats.misses++;
+        }
+    }
+    stats.triangles = indexCount / 3;
+    return stats;
+}
+
+// Tipsify: out gets the reordered triangles; clusterStarts (if given) gets the
+// first triangle of every run started after a cache flush (a dead end)
+inline void optimizeVertexCache(const uint32_t* indices, size_t indexCount, size_t vertexCount, std::vector<uint32_t>& out,
+                                std::vector<uint32_t>* clusterStarts = nullptr, unsigned int cacheSize = VERTEX_CACHE_SIZE)
+{
+    size_t triangleCount = indexCount / 3;
+    out.clear();
+    out.reserve(triangleCount * 3);
+    if (clusterStarts) clusterStarts->clear();
+    if (!triangleCount) return;
+
+    // vertex -> triangles, as offsets into one array
+    std::vector<uint32_t> live(vertexCount, 0), offsets(vertexCount + 1, 0), adjacency(triangleCount * 3);
+    for (size_t i = 0; i < triangleCount * 3; i++) live[indices[i]]++;
+    for (size_t v = 0; v < vertexCount; v++) offsets[v + 1] = offsets[v] + live[v];
+    std::vector<uint32_t> fill(offsets.begin(), offsets.end() - 1);
+    for (size_t i = 0; i < triangleCount * 3; i++) adjacency[fill[indices[i]]++] = static_cast<uint32_t>(i / 3);
+
+    std::vector<uint32_t> stamp(vertexCount, 0);
+    std::vector<uint8_t> emitted(triangleCount, 0);
+    std::vector<uint32_t> deadEnds, candidates;
+    uint32_t time = cacheSize + 1;
+    size_t cursor = 0; // scan position for the next vertex with live triangles
+    const uint32_t NONE = ~0u;
+    uint32_t fan = 0;
+    while (fan < vertexCount && !live[fan]) fan++;
+    if (clusterStarts) clusterStarts->push_back(0);
+
+    while (fan != NONE) {
+        candidates.clear();
+        for (uint32_t a = offsets[fan]; a < offsets[fan + 1]; a++) {
+            uint32_t t = adjacency[a];
+            if (emitted[t]) continue;
+            emitted[t] = 1;
+            for (int k = 0; k < 3; k++) {
+                uint32_t v = indices[t * 3 + k];
+                out.push_back(v);
+                deadEnds.push_back(v);
+                candidates.push_back(v);
+                live[v]--;
+                if (time - stamp[v] > cacheSize) stamp[v] = time++;
+            }
+        }
+
+        // best one-ring vertex still in the cache after its remaining triangles go out
+        fan = NONE;
+        int best = -1;
+        for (uint32_t v : candidates) {
+            if (!live[v]) continue;
+            int priority = 0;
+            if (time - stamp[v] + 2 * live[v] <= cacheSize) priority = static_cast<int>(time - stamp[v]);
+            if (priority > best) {
+                best = priority;
+                fan = v;
+            }
+        }
+        if (fan != NONE) continue;
+
+        // dead end: most recent vertex with work left, else the next one in index order
+        while (!deadEnds.empty() && fan == NONE) {
+            uint32_t v = deadEnds.back();
+            deadEnds.pop_back();
+            if (live[v]) fan = v;
+        }
+        while (fan == NONE && cursor < vertexCount) {
+            if (live[cursor]) fan = static_cast<uint32_t>(cursor);
+            cursor++;
+        }
+        if (fan != NONE && clusterStarts) clusterStarts->push_back(static_cast<uint32_t>(out.size() / 3));
+    }
+}
+
+// Reorders the clusters of a vertex-cache-optimized index list (from
+// optimizeVertexCache) to reduce overdraw; threshold 1.05 allows the ACMR to
+// grow by up to 5% to get smaller, better sortable clusters
+inline void optimizeOverdraw(std::vector<uint32_t>& indices, const std::vector<uint32_t>& clusterStarts, const void* positions,
+                             size_t stride, size_t vertexCount, float threshold = 1.05f,
+                             unsigned int cacheSize = VERTEX_CACHE_SIZE)
+{
+    size_t triangleCount = indices.size() / 3;
+    if (triangleCount < 2 || clusterStarts.empty()) return;
+    auto position = [positions, stride](uint32_t v) {
+        return *reinterpret_cast<const glm::vec3*>(static_cast<const unsigned char*>(positions) + v * stride);
+    };
+
+    // soft boundaries: inside each hard cluster, start a new one wherever the
+    // misses so far stay under threshold x the cluster's own ACMR
+    std::vector<uint32_t> stamp(vertexCount, 0);
+    uint32_t time = cacheSize + 1;
+    auto misses = [&](size_t t) {
+        int m = 0;
+        for (int k = 0; k < 3; k++) {
+            uint32_t v = indices[t * 3 + k];
+            if (time - stamp[v] > cacheSize) {
+                stamp[v] = time++;
+                m++;
+            }
+        }
+        return m;
+    };
+    std::vector<uint32_t> starts;
+    for (size_t c = 0; c < clusterStarts.size(); c++) {
+        size_t begin = clusterStarts[c];
+        size_t end = c + 1 < clusterStarts.size() ? clusterStarts[c + 1] : triangleCount;
+        time += cacheSize + 1; // flush
+        size_t clusterMisses = 0;
+        for (size_t t = begin; t < end; t++) clusterMisses += misses(t);
+        double limit = threshold * double(clusterMisses) / double(end - begin);
+
+        starts.push_back(static_cast<uint32_t>(begin));
+        time += cacheSize + 1;
+        size_t runMisses = 0, runTriangles = 0;
+        for (size_t t = begin; t < end; t++) {
+            runMisses += misses(t);
+            runTriangles++;
+            if (t + 1 < end && double(runMisses) <= limit * double(runTriangles)) {
+                starts.push_back(static_cast<uint32_t>(t + 1));
+                time += cacheSize + 1;
+                runMisses = runTriangles = 0;
+            }
+        }
+    }
+
+    // sort key: how much a cluster faces away from the mesh's centroid
+    struct Cluster {
+        uint32_t begin, end;
+        float key;
+    };
+    std::vector<Cluster> clusters;
+    glm::vec3 meshCentroid(0.0f);
+    float meshArea = 0.0f;
+    std::vector<glm::vec3> centroids, normals;
+    for (size_t c = 0; c < starts.size(); c++) {
+        uint32_t begin = starts[c];
+        uint32_t end = c + 1 < starts.size() ? starts[c + 1] : static_cast<uint32_t>(triangleCount);
+        glm::vec3 centroid(0.0f), normal(0.0f);
+        float area = 0.0f;
+        for (uint32_t t = begin; t < end; t++) {
+            glm::vec3 a = position(indices[t * 3]), b = position(indices[t * 3 + 1]), d = position(indices[t * 3 + 2]);
+            glm::vec3 n = glm::cross(b - a, d - a); // length = 2 x area
+            float w = glm::length(n);
+            centroid += (a + b + d) * (w / 3.0f);
+            normal += n;
+            area += w;
+        }
+        meshCentroid += centroid;
+        meshArea += area;
+        centroids.push_back(area > 0.0f ? centroid / area : centroid);
+        float len = glm::length(normal);
+        normals.push_back(len > 0.0f ? normal / len : normal);
+        clusters.push_back({ begin, end, 0.0f });
+    }
+    if (meshArea > 0.0f) meshCentroid = meshCentroid / meshArea;
+    for (size_t c = 0; c < clusters.size(); c++) clusters[c].key = glm::dot(centroids[c] - meshCentroid, normals[c]);
+    std::stable_sort(clusters.begin(), clusters.end(), [](const Cluster& a, const Cluster& b) { return a.key > b.key; });
+
+    std::vector<uint32_t> sorted;
+    sorted.reserve(indices.size());
+    for (const Cluster& c : clusters) sorted.insert(sorted.end(), indices.begin() + c.begin * 3, indices.begin() + c.end * 3);
+    indices.swap(sorted);
+}
+
+// first-use vertex order: remap[old] = new index, or ~0u for unreferenced
+// vertices; indices are rewritten, returns the number of vertices kept
+inline size_t optimizeVertexFetchRemap(std::vector<uint32_t>& indices, size_t vertexCount, std::vector<uint32_t>& remap)
+{
+    remap.assign(vertexCount, ~0u);
+    uint32_t next = 0;
+    for (uint32_t& v : indices) {
+        if (remap[v] == ~0u) remap[v] = next++;
+        v = remap[v];
+    }
+    return next;
+}
+
+#endif
@@ -0,0 +1,279 @@
+#ifndef MESH_SIMPLIFIER_H
+#define MESH_SIMPLIFIER_H
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <unordered_map>
+#include <vector>
+
+// Quadric error metric simplification (Garland & Heckbert 1997) by edge
+// collapse onto existing vertices: only the index list changes, so every
+// level of detail can share the full mesh's vertex buffer.
+//
+// Each vertex carries the sum of its triangles' area-weighted plane quadrics;
+// collapsing a into b costs (Qa + Qb)(b), the area-weighted mean squared
+// distance of b from the planes of both, so errors are in model units. Every
+// pass sorts the candidate collapses by cost and applies the cheap ones whose
+// one-rings don't overlap and that turn no triangle's normal by more than
+// about 75 degrees, until the target triangle count or the error limit is
+// reached. (Testing only for a flip let turns just under 90 degrees pile up
+// over passes into folded triangles.)
+//
+// The quadric cost is an area-weighted mean, not a bound, so the error
+// returned is measured afterwards: the largest distance from a removed vertex
+// to the triangles within two rings of the vertex it ended up collapsed into.
+//
+// Vertices on open borders, non-manifold edges or attribute seams (several
+// vertices at one position, e.g. a UV seam) are never moved, so silhouettes
+// and texture seams don't tear; other vertices may collapse onto them. The
+// input must be welded: with one vertex per face corner, as an OBJ import
+// without JoinIdenticalVertices gives, every vertex looks like a seam and
+// nothing collapses.
+
+struct Quadric {
+    double m[10] = {}; // upper triangle of the symmetric 4x4: xx xy xz xw yy yz yw zz zw ww
+    double weight = 0.0;
+
+    static Quadric plane(const glm::vec3& n, float d, float weight)
+    {
+        Quadric q;
+        double a = n.x, b = n.y, c = n.z, w = d;
+        double v[10] = { a * a, a * b, a * c, a * w, b * b, b * c, b * w, c * c, c * w, w * w };
+        for (int i = 0; i < 10; i++) q.m[i] = v[i] * weight;
+        q.weight = weight;
+        return q;
+    }
+
+    Quadric& operator+=(const Quadric& o)
+    {
+        for (int i = 0; i < 10; i++) m[i] += o.m[i];
+        weight += o.weight;
+        return *this;
+    }
+
+    // mean squared distance of p to the planes (area weighted); an estimate, the
+    // distance to a single plane can be larger
+    double error(const glm::vec3& p) const
+    {
+        double x = p.x, y = p.y, z = p.z;
+        double e = m[0] * x * x + 2 * m[1] * x * y + 2 * m[2] * x * z + 2 * m[3] * x + m[4] * y * y + 2 * m[5] * y * z +
+                   2 * m[6] * y + m[7] * z * z + 2 * m[8] * z + m[9];
+        return weight > 0.0 ? std::max(0.0, e) / weight : 0.0;
+    }
+};
+
+// squared distance from p to triangle abc (closest point by Voronoi region)
+inline float pointTriangleDistanceSquared(const glm::vec3& p, const glm::vec3& a, const glm::vec3& b, const glm::vec3& c)
+{
+    glm::vec3 ab = b - a, ac = c - a, ap = p - a;
+    float d1 = glm::dot(ab, ap), d2 = glm::dot(ac, ap);
+    glm::vec3 closest;
+    if (d1 <= 0.0f && d2 <= 0.0f) {
+        closest = a;
+    }
+    else {
+        glm::vec3 bp = p - b, cp = p - c;
+        float d3 = glm::dot(ab, bp), d4 = glm::dot(ac, bp);
+        float d5 = glm::dot(ab, cp), d6 = glm::dot(ac, cp);
+        float va = d3 * d6 - d5 * d4, vb = d5 * d2 - d1 * d6, vc = d1 * d4 - d3 * d2;
+        if (d3 >= 0.0f && d4 <= d3) closest = b;
+        else if (d6 >= 0.0f && d5 <= d6) closest = c;
+        else if (vc <= 0.0f && d1 >= 0.0f && d3 <= 0.0f) closest = a + ab * (d1 / (d1 - d3));
+        else if (vb <= 0.0f && d2 >= 0.0f && d6 <= 0.0f) closest = a + ac * (d2 / (d2 - d6));
+        else if (va <= 0.0f && d4 - d3 >= 0.0f && d5 - d6 >= 0.0f) closest = b + (c - b) * ((d4 - d3) / ((d4 - d3) + (d5 - d6)));
+        else closest = a + ab * (vb / (va + vb + vc)) + ac * (vc / (va + vb + vc));
+    }
+    glm::vec3 d = p - closest;
+    return glm::dot(d, d);
+}
+
+// Simplifies a triangle list towards targetIndexCount indices; no collapse's
+// quadric error goes past maxError (model units). out gets the new triangles
+// over the same vertices; returns the measured deviation, in model units.
+inline float simplifyMesh(const uint32_t* indices, size_t indexCount, const void* positions, size_t stride, size_t vertexCount,
+                          size_t targetIndexCount, float maxError, std::vector<uint32_t>& out)
+{
+    out.assign(indices, indices + indexCount - indexCount % 3);
+    if (out.size() <= targetIndexCount) return 0.0f;
+    auto position = [positions, stride](uint32_t v) {
+        return *reinterpret_cast<const glm::vec3*>(static_cast<const unsigned char*>(positions) + v * stride);
+    };
+
+    // weld by position: welded[v] = first vertex at the same spot
+    std::vector<uint32_t> welded(vertexCount), copies(vertexCount, 0);
+    {
+        struct Hash {
+            size_t operator()(const glm::vec3& p) const
+            {
+                uint32_t h[3];
+                std::memcpy(h, &p, sizeof(h));
+                return (h[0] * 73856093u) ^ (h[1] * 19349663u) ^ (h[2] * 83492791u);
+            }
+        };
+        struct Equal {
+            bool operator()(const glm::vec3& a, const glm::vec3& b) const { return a.x == b.x && a.y == b.y && a.z == b.z; }
+        };
+        std::unordered_map<glm::vec3, uint32_t, Hash, Equal> first;
+        first.reserve(vertexCount);
+        for (uint32_t v = 0; v < vertexCount; v++) {
+            welded[v] = first.emplace(position(v), v).first->second;
+            copies[welded[v]]++;
+        }
+    }
+
+    // locked: seams, borders and non-manifold edges (edges counted on welded positions)
+    std::vector<uint8_t> locked(vertexCount, 0);
+    {
+        std::unordered_map<uint64_t, uint32_t> edgeUse;
+        edgeUse.reserve(out.size());
+        for (size_t i = 0; i < out.size(); i += 3)
+            for (int k = 0; k < 3; k++) {
+                uint32_t a = welded[out[i + k]], b = welded[out[i + (k + 1) % 3]];
+                edgeUse[uint64_t(std::min(a, b)) << 32 | std::max(a, b)]++;
+            }
+        for (const auto& e : edgeUse)
+            if (e.second != 2) {
+                locked[e.first >> 32] = 1;
+                locked[e.first & 0xffffffffu] = 1;
+            }
+        for (uint32_t v = 0; v < vertexCount; v++)
+            if (copies[welded[v]] > 1 || locked[welded[v]]) locked[v] = 1;
+    }
+
+    // quadrics, per welded position
+    std::vector<Quadric> quadrics(vertexCount);
+    for (size_t i = 0; i < out.size(); i += 3) {
+        glm::vec3 p0 = position(out[i]), p1 = position(out[i + 1]), p2 = position(out[i + 2]);
+        glm::vec3 n = glm::cross(p1 - p0, p2 - p0);
+        float area = glm::length(n);
+        if (area <= 0.0f) continue;
+        n = n / area;
+        Quadric q = Quadric::plane(n, -glm::dot(n, p0), area * 0.5f);
+        for (int k = 0; k < 3; k++) quadrics[welded[out[i + k]]] += q;
+    }
+
+    struct Collapse {
+        uint32_t from, to;
+        double cost;
+    };
+    std::vector<Collapse> candidates;
+    std::vector<uint32_t> offsets(vertexCount + 1), adjacency, fill, remap(vertexCount);
+    std::vector<uint8_t> touched(vertexCount);
+    std::vector<uint32_t> collapsedInto(vertexCount); // final target of every removed vertex
+    for (uint32_t v = 0; v < vertexCount; v++) collapsedInto[v] = v;
+    double limit = double(maxError) * maxError;
+
+    while (out.size() > targetIndexCount) {
+        size_t triangles = out.size() / 3, target = targetIndexCount / 3;
+
+        // vertex -> triangles
+        std::fill(offsets.begin(), offsets.end(), 0);
+        for (uint32_t v : out) offsets[v + 1]++;
+        for (size_t v = 0; v < vertexCount; v++) offsets[v + 1] += offsets[v];
+        adjacency.resize(out.size());
+        fill.assign(offsets.begin(), offsets.end() - 1);
+        for (size_t i = 0; i < out.size(); i++) adjacency[fill[out[i]]++] = static_cast<uint32_t>(i / 3);
+
+        candidates.clear();
+        for (size_t i = 0; i < out.size(); i += 3)
+            for (int k = 0; k < 3; k++) {
+                uint32_t a = out[i + k], b = out[i + (k + 1) % 3];
+                if (!locked[a]) {
+                    Quadric q = quadrics[welded[a]];
+                    q += quadrics[welded[b]];
+                    candidates.push_back({ a, b, q.error(position(b)) });
+                }
+            }
+        std::sort(candidates.begin(), candidates.end(), [](const Collapse& x, const Collapse& y) { return x.cost < y.cost; });
+
+        for (uint32_t v = 0; v < vertexCount; v++) remap[v] = v;
+        std::fill(touched.begin(), touched.end(), 0);
+        size_t collapsed = 0;
+        for (const Collapse& c : candidates) {
+            if (c.cost > limit || triangles <= target) break;
+            if (touched[c.from] || touched[c.to]) continue;
+
+            // the one-ring must be untouched this pass and no normal may turn past ~75 degrees
+            bool ok = true;
+            size_t removed = 0;
+            glm::vec3 to = position(c.to);
+            for (uint32_t a = offsets[c.from]; a < offsets[c.from + 1] && ok; a++) {
+                const uint32_t* t = &out[adjacency[a] * 3];
+                bool hasTo = false;
+                for (int k = 0; k < 3; k++) {
+                    ok = ok && !touched[t[k]];
+                    hasTo = hasTo || t[k] == c.to;
+                }
+                if (hasTo) {
+                    removed++;
+                    continue;
+                }
+                glm::vec3 p[3], q[3];
+                for (int k = 0; k < 3; k++) {
+                    p[k] = position(t[k]);
+                    q[k] = t[k] == c.from ? to : p[k];
+                }
+                glm::vec3 before = glm::cross(p[1] - p[0], p[2] - p[0]), after = glm::cross(q[1] - q[0], q[2] - q[0]);
+                ok = ok && glm::dot(before, after) > 0.25f * glm::length(before) * glm::length(after);
+            }
+            if (!ok) continue;
+
+            remap[c.from] = c.to;
+            collapsedInto[c.from] = c.to;
+            quadrics[welded[c.to]] += quadrics[welded[c.from]];
+            for (uint32_t a = offsets[c.from]; a < offsets[c.from + 1]; a++)
+                for (int k = 0; k < 3; k++) touched[out[adjacency[a] * 3 + k]] = 1;
+            triangles -= removed;
+            collapsed++;
+        }
+        if (!collapsed) break;
+
+        // apply, dropping triangles that lost a corner
+        size_t kept = 0;
+        for (size_t i = 0; i < out.size(); i += 3) {
+            uint32_t a = remap[out[i]], b = remap[out[i + 1]], d = remap[out[i + 2]];
+            if (a == b || b == d || a == d) continue;
+            out[kept++] = a;
+            out[kept++] = b;
+            out[kept++] = d;
+        }
+        out.resize(kept);
+    }
+
+    // deviation: every removed vertex against the triangles around its final
+    // target (and the target's seam copies, through the welded position)
+    std::fill(offsets.begin(), offsets.end(), 0);
+    for (uint32_t v : out) offsets[welded[v] + 1]++;
+    for (size_t v = 0; v < vertexCount; v++) offsets[v + 1] += offsets[v];
+    adjacency.resize(out.size());
+    fill.assign(offsets.begin(), offsets.end() - 1);
+    for (size_t i = 0; i < out.size(); i++) adjacency[fill[welded[out[i]]]++] = static_cast<uint32_t>(i / 3);
+    float worst = 0.0f;
+    for (uint32_t v = 0; v < vertexCount; v++) {
+        if (collapsedInto[v] == v) continue;
+        uint32_t target = collapsedInto[v];
+        while (collapsedInto[target] != target) target = collapsedInto[target];
+        collapsedInto[v] = target;
+        uint32_t w = welded[target];
+        if (offsets[w] == offsets[w + 1]) continue; // target lost all its triangles
+        float nearest = FLT_MAX;
+        for (uint32_t a = offsets[w]; a < offsets[w + 1]; a++)
+            for (int k = 0; k < 3; k++) {
+                uint32_t n = welded[out[adjacency[a] * 3 + k]];
+                for (uint32_t b = offsets[n]; b < offsets[n + 1]; b++) {
+                    const uint32_t* t = &out[adjacency[b] * 3];
+                    nearest = std::min(nearest, pointTriangleDistanceSquared(position(v), position(t[0]), position(t[1]), position(t[2])));
+                }
+            }
+        worst = std::max(worst, nearest);
+    }
+    return std::sqrt(worst);
+}
+
+#endif
@@ -0,0 +1,585 @@
+#ifndef MODEL_CACHE_H
+#define MODEL_CACHE_H
+
+#include <learnopengl/model.h>
+
+#include "collision.h"
+#include "mesh_optimizer.h"
+#include "mesh_simplifier.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// Cooked binary copy of a Model, written next to the source OBJ
+// ("Winter_Girl.obj.meshcache") the first time it is imported. Later runs map
+// the file and hand the vertex / index blobs straight to GL (see PackedModel),
+// skipping the OBJ parse. The header carries a format version, sizeof(Vertex)
+// and a hash of the OBJ and its .mtl files; any mismatch makes open() fail and
+// the caller cooks the cache again. Importing and cooking make no GL calls, so
+// both can run on a loader thread.
+//
+// Cooking also welds identical vertices and reorders every mesh for the vertex
+// cache, overdraw and vertex fetch (mesh_optimizer.h); the header keeps the
+// ACMR / ATVR from before and after, so cache loads can still report them.
+//
+// Each mesh also gets a chain of coarser levels of detail (mesh_simplifier.h),
+// level 0 being the mesh itself. The levels reuse the mesh's vertices; only
+// their indices are stored, after the mesh's own.
+//
+// Layout (native endianness, the cache is per machine):
+//   ModelCacheHeader
+//   CookedMesh[meshCount]
+//   CookedLod[lodCount]           per mesh at firstLod, finest first
+//   CookedTexture[textureCount]   type / path as offsets into the string blob
+//   string blob
+//   Vertex[vertexCount]           at vertexOffset, 16-byte aligned
+//   uint32_t[indexCount]          at indexOffset; every mesh's, then every LOD's, relative to the
+//                                 mesh's firstVertex
+
+const uint32_t MODEL_CACHE_VERSION = 5;
+static_assert(sizeof(unsigned int) == sizeof(uint32_t), "Mesh indices are written as uint32_t");
+
+struct ModelCacheHeader {
+    char magic[8];        // "MESHCACH"
+    uint32_t version;
+    uint32_t vertexStride; // sizeof(Vertex) when written
+    uint64_t sourceHash;
+    uint32_t meshCount;
+    uint32_t textureCount;
+    uint32_t lodCount;
+    uint32_t pad;
+    uint64_t vertexCount;
+    uint64_t indexCount;
+    float boundsMin[3], boundsMax[3];
+    float acmr[2], atvr[2]; // before / after optimizeModelData, FIFO cache of VERTEX_CACHE_SIZE
+    uint64_t meshOffset, lodOffset, textureOffset, stringOffset, vertexOffset, indexOffset;
+    uint64_t fileSize;
+};
+
+struct CookedMesh {
+    uint32_t firstVertex, vertexCount;
+    uint32_t firstIndex, indexCount;
+    uint32_t firstTexture, textureCount;
+    uint32_t firstLod, lodCount;
+    float boundsMin[3], boundsMax[3];
+};
+
+// one level of detail: indices relative to the mesh's firstVertex, like the mesh's own
+struct CookedLod {
+    uint32_t firstIndex, indexCount;
+    float error; // largest distance of a removed vertex from this level's surface, model units
+};
+
+struct CookedTexture {
+    uint32_t typeOffset, typeLength; // "texture_diffuse", ...
+    uint32_t pathOffset, pathLength; // relative to the model's directory, as in the material
+};
+
+// read-only view of a whole file
+class MappedFile {
+public:
+    MappedFile() = default;
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    ~MappedFile() { close(); }
+
+    bool open(const std::string& path)
+    {
+        close();
+#ifdef _WIN32
+        file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (file == INVALID_HANDLE_VALUE) return false;
+        LARGE_INTEGER size;
+        if (!GetFileSizeEx(file, &size) || size.QuadPart == 0) { close(); return false; }
+        mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (!mapping) { close(); return false; }
+        bytes = static_cast<const unsigned char*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+        length = static_cast<size_t>(size.QuadPart);
+#else
+        fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) return false;
+        struct stat st;
+        if (fstat(fd, &st) != 0 || st.st_size == 0) { close(); return false; }
+        void* p = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+        if (p == MAP_FAILED) { close(); return false; }
+        bytes = static_cast<const unsigned char*>(p);
+        length = static_cast<size_t>(st.st_size);
+#endif
+        if (!bytes) { close(); return false; }
+        return true;
+    }
+
+    void close()
+    {
+#ifdef _WIN32
+        if (bytes) UnmapViewOfFile(bytes);
+        if (mapping) CloseHandle(mapping);
+        if (file != INVALID_HANDLE_VALUE) CloseHandle(file);
+        mapping = nullptr;
+        file = INVALID_HANDLE_VALUE;
+#else
+        if (bytes) munmap(const_cast<unsigned char*>(bytes), length);
+        if (fd >= 0) ::close(fd);
+        fd = -1;
+#endif
+        bytes = nullptr;
+        length = 0;
+    }
+
+    const unsigned char* data() const { return bytes; }
+    size_t size() const { return length; }
+
+private:
+    const unsigned char* bytes = nullptr;
+    size_t length = 0;
+#ifdef _WIN32
+    HANDLE file = INVALID_HANDLE_VALUE;
+    HANDLE mapping = nullptr;
+#else
+    int fd = -1;
+#endif
+};
+
+inline std::string modelCachePath(const std::string& sourcePath) { return sourcePath + ".meshcache"; }
+
+// FNV-1a over the OBJ and every mtllib it names; 0 if the OBJ can't be read
+inline uint64_t hashModelSource(const std::string& sourcePath)
+{
+    MappedFile obj;
+    if (!obj.open(sourcePath)) return 0;
+    uint64_t h = 14695981039346656037ull;
+    auto hashBytes = [&h](const unsigned char* p, size_t n) {
+        for (size_t i = 0; i < n; i++) {
+            h ^= p[i];
+            h *= 1099511628211ull;
+        }
+    };
+    hashBytes(obj.data(), obj.size());
+
+    std::string directory = sourcePath.substr(0, sourcePath.find_last_of("/\\") + 1);
+    const char* text = reinterpret_cast<const char*>(obj.data());
+    for (size_t i = 0; i + 7 < obj.size(); i++) {
+        if ((i > 0 && text[i - 1] != '\n') || std::strncmp(text + i, "mtllib ", 7) != 0) continue;
+        size_t end = i + 7;
+        while (end < obj.size() && text[end] != '\n' && text[end] != '\r') end++;
+        MappedFile mtl;
+        if (mtl.open(directory + std::string(text + i + 7, end - i - 7))) hashBytes(mtl.data(), mtl.size());
+    }
+    return h;
+}
+
+// a model in cache layout, in memory: what importModel produces and cookModel serializes
+struct ModelData {
+    std::vector<CookedMesh> meshes;
+    std::vector<std::string> textureTypes, texturePaths; // per texture, meshes index them through firstTexture
+    std::vector<Vertex> vertices;
+    std::vector<uint32_t> indices;   // per mesh, relative to its firstVertex
+    std::vector<uint8_t> triangleList; // per mesh: only triangles, so it can be reordered
+    std::vector<CookedLod> lods;       // per mesh from firstLod, see buildModelLods
+    VertexCacheStats cacheBefore, cacheAfter;
+};
+
+// a cooked model, mapped from its cache file or held in memory; all pointers
+// stay valid until close()
+class CookedModel {
+public:
+    // false if the cache is missing, malformed, from another version / build, or older than the source
+    bool open(const std::string& cachePath, const std::string& sourcePath)
+    {
+        close();
+        if (!file.open(cachePath)) return false;
+        base = file.data();
+        length = file.size();
+        if (!validate() || header.sourceHash != hashModelSource(sourcePath)) return fail();
+        directory = sourcePath.substr(0, sourcePath.find_last_of("/\\"));
+        return true;
+    }
+
+    // take a blob from cookModel, for when the cache file couldn't be written (or read back)
+    bool adopt(std::vector<unsigned char>&& blob, const std::string& sourcePath)
+    {
+        close();
+        owned = std::move(blob);
+        base = owned.data();
+        length = owned.size();
+        if (!validate()) return fail();
+        directory = sourcePath.substr(0, sourcePath.find_last_of("/\\"));
+        return true;
+    }
+
+    void close()
+    {
+        file.close();
+        owned.clear();
+        base = nullptr;
+        length = 0;
+        directory.clear();
+    }
+
+    size_t meshCount() const { return header.meshCount; }
+    const CookedMesh& mesh(size_t i) const { return reinterpret_cast<const CookedMesh*>(base + header.meshOffset)[i]; }
+    const Vertex* vertices() const { return reinterpret_cast<const Vertex*>(base + header.vertexOffset); }
+    const uint32_t* indices() const { return reinterpret_cast<const uint32_t*>(base + header.indexOffset); }
+    const CookedLod& lod(size_t i) const { return reinterpret_cast<const CookedLod*>(base + header.lodOffset)[i]; }
+    size_t lodCount() const { return header.lodCount; }
+    size_t vertexCount() const { return static_cast<size_t>(header.vertexCount); }
+    size_t indexCount() const { return static_cast<size_t>(header.indexCount); }
+    size_t textureCount() const { return header.textureCount; }
+
+    std::string textureType(size_t i) const { return blobString(texture(i).typeOffset, texture(i).typeLength); }
+    std::string texturePath(size_t i) const { return blobString(texture(i).pathOffset, texture(i).pathLength); }
+
+    Box bounds() const
+    {
+        return { glm::vec3(header.boundsMin[0], header.boundsMin[1], header.boundsMin[2]),
+                 glm::vec3(header.boundsMax[0], header.boundsMax[1], header.boundsMax[2]) };
+    }
+
+    // where the textures are, like Model::directory
+    const std::string& sourceDirectory() const { return directory; }
+
+    // vertex cache efficiency of the whole model as imported and as cooked
+    float acmr(bool optimized) const { return header.acmr[optimized ? 1 : 0]; }
+    float atvr(bool optimized) const { return header.atvr[optimized ? 1 : 0]; }
+
+private:
+    MappedFile file;
+    std::vector<unsigned char> owned;
+    const unsigned char* base = nullptr;
+    size_t length = 0;
+    ModelCacheHeader header = {};
+    std::string directory;
+
+    bool validate()
+    {
+        if (length < sizeof(ModelCacheHeader)) return false;
+        std::memcpy(&header, base, sizeof(header));
+        if (std::memcmp(header.magic, "MESHCACH", 8) != 0 || header.version != MODEL_CACHE_VERSION ||
+            header.vertexStride != sizeof(Vertex) || header.fileSize != length)
+            return false;
+        if (!inside(header.meshOffset, header.meshCount * sizeof(CookedMesh)) ||
+            !inside(header.lodOffset, header.lodCount * sizeof(CookedLod)) ||
+            !inside(header.textureOffset, header.textureCount * sizeof(CookedTexture)) ||
+            !inside(header.vertexOffset, header.vertexCount * sizeof(Vertex)) ||
+            !inside(header.indexOffset, header.indexCount * sizeof(uint32_t)) || header.stringOffset > length)
+            return false;
+        for (size_t i = 0; i < header.meshCount; i++) {
+            const CookedMesh& m = mesh(i);
+            if (uint64_t(m.firstVertex) + m.vertexCount > header.vertexCount || uint64_t(m.firstIndex) + m.indexCount > header.indexCount ||
+                uint64_t(m.firstTexture) + m.textureCount > header.textureCount ||
+                uint64_t(m.firstLod) + m.lodCount > header.lodCount)
+                return false;
+        }
+        for (size_t i = 0; i < header.lodCount; i++)
+            if (uint64_t(lod(i).firstIndex) + lod(i).indexCount > header.indexCount) return false;
+        return true;
+    }
+
+    bool fail()
+    {
+        close();
+        header = ModelCacheHeader();
+        return false;
+    }
+
+    bool inside(uint64_t offset, uint64_t bytes) const { return offset <= length && bytes <= length - offset; }
+
+    const CookedTexture& texture(size_t i) const
+    {
+        return reinterpret_cast<const CookedTexture*>(base + header.textureOffset)[i];
+    }
+
+    std::string blobString(uint32_t offset, uint32_t count) const
+    {
+        const char* blob = reinterpret_cast<const char*>(base + header.stringOffset);
+        size_t available = length - header.stringOffset;
+        if (offset > available || count > available - offset) return std::string();
+        return std::string(blob + offset, count);
+    }
+};
+
+// Model's Assimp import (same post-processing plus JoinIdenticalVertices, node
+// order, vertex fill and material texture types) into a ModelData; textures
+// are only named, not loaded
+inline void importModelNode(const aiNode* node, const aiScene* scene, ModelData& out)
+{
+    static const aiTextureType materialTypes[] = { aiTextureType_DIFFUSE, aiTextureType_SPECULAR, aiTextureType_HEIGHT,
+                                                   aiTextureType_AMBIENT };
+    static const char* typeNames[] = { "texture_diffuse", "texture_specular", "texture_normal", "texture_height" };
+
+    for (unsigned int n = 0; n < node->mNumMeshes; n++) {
+        const aiMesh* mesh = scene->mMeshes[node->mMeshes[n]];
+        CookedMesh cm = {};
+        cm.firstVertex = static_cast<uint32_t>(out.vertices.size());
+        cm.vertexCount = mesh->mNumVertices;
+        cm.firstIndex = static_cast<uint32_t>(out.indices.size());
+        cm.firstTexture = static_cast<uint32_t>(out.texturePaths.size());
+        Box b = emptyBox();
+        for (unsigned int i = 0; i < mesh->mNumVertices; i++) {
+            Vertex v = {};
+            v.Position = glm::vec3(mesh->mVertices[i].x, mesh->mVertices[i].y, mesh->mVertices[i].z);
+            if (mesh->HasNormals()) v.Normal = glm::vec3(mesh->mNormals[i].x, mesh->mNormals[i].y, mesh->mNormals[i].z);
+            if (mesh->mTextureCoords[0]) {
+                v.TexCoords = glm::vec2(mesh->mTextureCoords[0][i].x, mesh->mTextureCoords[0][i].y);
+                v.Tangent = glm::vec3(mesh->mTangents[i].x, mesh->mTangents[i].y, mesh->mTangents[i].z);
+                v.Bitangent = glm::vec3(mesh->mBitangents[i].x, mesh->mBitangents[i].y, mesh->mBitangents[i].z);
+            }
+            growBox(b, v.Position);
+            out.vertices.push_back(v);
+        }
+        bool triangles = true;
+        for (unsigned int f = 0; f < mesh->mNumFaces; f++) {
+            triangles = triangles && mesh->mFaces[f].mNumIndices == 3;
+            for (unsigned int k = 0; k < mesh->mFaces[f].mNumIndices; k++) out.indices.push_back(mesh->mFaces[f].mIndices[k]);
+        }
+        cm.indexCount = static_cast<uint32_t>(out.indices.size()) - cm.firstIndex;
+        out.triangleList.push_back(triangles ? 1 : 0);
+
+        const aiMaterial* material = scene->mMaterials[mesh->mMaterialIndex];
+        for (int t = 0; t < 4; t++) {
+            for (unsigned int i = 0; i < material->GetTextureCount(materialTypes[t]); i++) {
+                aiString path;
+                material->GetTexture(materialTypes[t], i, &path);
+                out.textureTypes.push_back(typeNames[t]);
+                out.texturePaths.push_back(path.C_Str());
+            }
+        }
+        cm.textureCount = static_cast<uint32_t>(out.texturePaths.size()) - cm.firstTexture;
+        for (int k = 0; k < 3; k++) {
+            cm.boundsMin[k] = cm.vertexCount ? b.min[k] : 0.0f;
+            cm.boundsMax[k] = cm.vertexCount ? b.max[k] : 0.0f;
+        }
+        out.meshes.push_back(cm);
+    }
+    for (unsigned int c = 0; c < node->mNumChildren; c++) importModelNode(node->mChildren[c], scene, out);
+}
+
+inline bool importModel(const std::string& path, ModelData& out)
+{
+    out = ModelData();
+    Assimp::Importer importer;
+    const aiScene* scene = importer.ReadFile(path, aiProcess_Triangulate | aiProcess_GenSmoothNormals | aiProcess_FlipUVs |
+                                                       aiProcess_CalcTangentSpace | aiProcess_JoinIdenticalVertices);
+    if (!scene || scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE || !scene->mRootNode) {
+        std::cerr << "ERROR::ASSIMP:: " << importer.GetErrorString() << std::endl;
+        return false;
+    }
+    importModelNode(scene->mRootNode, scene, out);
+    return true;
+}
+
+// identical vertices welded, then vertex cache, overdraw and fetch order for
+// every triangle-list mesh (see mesh_optimizer.h); unreferenced vertices are
+// dropped, cache stats recorded (before = as imported)
+inline void optimizeModelData(ModelData& data)
+{
+    std::vector<Vertex> vertices;
+    std::vector<uint32_t> indices, welded, meshIndices, clusterStarts, remap;
+    vertices.reserve(data.vertices.size());
+    indices.reserve(data.indices.size());
+    data.cacheBefore = data.cacheAfter = VertexCacheStats();
+    for (size_t i = 0; i < data.meshes.size(); i++) {
+        CookedMesh& m = data.meshes[i];
+        const uint32_t* source = data.indices.data() + m.firstIndex;
+        VertexCacheStats before = analyzeVertexCache(source, m.indexCount, m.vertexCount);
+        data.cacheBefore += before;
+        if (m.vertexCount) {
+            weldVertices(&data.vertices[m.firstVertex], sizeof(Vertex), m.vertexCount, remap);
+            welded.resize(m.indexCount);
+            for (size_t k = 0; k < m.indexCount; k++) welded[k] = remap[source[k]];
+            source = welded.data();
+        }
+        if (m.indexCount && i < data.triangleList.size() && data.triangleList[i]) {
+            optimizeVertexCache(source, m.indexCount, m.vertexCount, meshIndices, &clusterStarts);
+            optimizeOverdraw(meshIndices, clusterStarts, &data.vertices[m.firstVertex].Position, sizeof(Vertex), m.vertexCount);
+        }
+        else {
+            meshIndices.assign(source, source + m.indexCount);
+        }
+        size_t kept = optimizeVertexFetchRemap(meshIndices, m.vertexCount, remap);
+        size_t firstVertex = vertices.size();
+        vertices.resize(firstVertex + kept);
+        for (size_t v = 0; v < m.vertexCount; v++)
+            if (remap[v] != ~0u) vertices[firstVertex + remap[v]] = data.vertices[m.firstVertex + v];
+        m.firstVertex = static_cast<uint32_t>(firstVertex);
+        m.vertexCount = static_cast<uint32_t>(kept);
+        m.firstIndex = static_cast<uint32_t>(indices.size());
+        indices.insert(indices.end(), meshIndices.begin(), meshIndices.end());
+        data.cacheAfter += analyzeVertexCache(meshIndices.data(), meshIndices.size(), kept);
+    }
+    data.vertices.swap(vertices);
+    data.indices.swap(indices);
+}
+
+// LODs give up at most this fraction of the mesh's size (bounding box diagonal)
+const float MODEL_LOD_MAX_ERROR = 0.02f;
+const unsigned int MODEL_LOD_LEVELS = 4; // including the full mesh
+
+// triangles facing away from the vertex normals at their corners; a level
+// with more of them than the full mesh has folded somewhere
+inline size_t countInvertedTriangles(const uint32_t* indices, size_t indexCount, const Vertex* vertices)
+{
+    size_t inverted = 0;
+    for (size_t i = 0; i + 2 < indexCount; i += 3) {
+        const Vertex &a = vertices[indices[i]], &b = vertices[indices[i + 1]], &c = vertices[indices[i + 2]];
+        glm::vec3 face = glm::cross(b.Position - a.Position, c.Position - a.Position);
+        if (glm::dot(face, a.Normal + b.Normal + c.Normal) < 0.0f) inverted++;
+    }
+    return inverted;
+}
+
+// level 0 is the mesh as it is; each further level aims at half the triangles
+// of the one before, simplified from the full mesh so errors don't stack. The
+// chain stops early once a level saves less than 10%, deviates more than the
+// error limit or has folded triangles (which would be a simplifier bug).
+// Level indices go after all the meshes' own and are vertex cache ordered.
+// Runs after optimizeModelData, whose weld the simplifier relies on.
+inline void buildModelLods(ModelData& data)
+{
+    data.lods.clear();
+    std::vector<uint32_t> simplified, ordered;
+    for (size_t i = 0; i < data.meshes.size(); i++) {
+        CookedMesh& m = data.meshes[i];
+        m.firstLod = static_cast<uint32_t>(data.lods.size());
+        data.lods.push_back({ m.firstIndex, m.indexCount, 0.0f });
+        if (m.indexCount && i < data.triangleList.size() && data.triangleList[i]) {
+            glm::vec3 extent(m.boundsMax[0] - m.boundsMin[0], m.boundsMax[1] - m.boundsMin[1], m.boundsMax[2] - m.boundsMin[2]);
+            float maxError = MODEL_LOD_MAX_ERROR * glm::length(extent);
+            size_t previous = m.indexCount;
+            size_t inverted = countInvertedTriangles(data.indices.data() + m.firstIndex, m.indexCount, &data.vertices[m.firstVertex]);
+            for (unsigned int level = 1; level < MODEL_LOD_LEVELS; level++) {
+                size_t target = (m.indexCount >> level) / 3 * 3;
+                float error = simplifyMesh(data.indices.data() + m.firstIndex, m.indexCount, &data.vertices[m.firstVertex].Position,
+                                           sizeof(Vertex), m.vertexCount, target, maxError, simplified);
+                if (level == 1 && simplified.size() == m.indexCount && m.indexCount >= 3 * 64)
+                    std::cerr << "Warning: mesh " << i << " has nothing to collapse (unwelded vertices?), no LODs\n";
+                if (simplified.empty() || simplified.size() * 10 > previous * 9 || error > maxError) break;
+                if (countInvertedTriangles(simplified.data(), simplified.size(), &data.vertices[m.firstVertex]) > inverted) {
+                    std::cerr << "Warning: LOD " << level << " of mesh " << i << " has folded triangles, dropped\n";
+                    break;
+                }
+                optimizeVertexCache(simplified.data(), simplified.size(), m.vertexCount, ordered);
+                data.lods.push_back({ static_cast<uint32_t>(data.indices.size()), static_cast<uint32_t>(ordered.size()), error });
+                data.indices.insert(data.indices.end(), ordered.begin(), ordered.end());
+                previous = ordered.size();
+            }
+        }
+        m.lodCount = static_cast<uint32_t>(data.lods.size()) - m.firstLod;
+    }
+}
+
+// the whole cache file for data, in memory
+inline std::vector<unsigned char> cookModel(const ModelData& data, uint64_t sourceHash)
+{
+    ModelCacheHeader header = {};
+    std::memcpy(header.magic, "MESHCACH", 8);
+    header.version = MODEL_CACHE_VERSION;
+    header.vertexStride = sizeof(Vertex);
+    header.sourceHash = sourceHash;
+    header.meshCount = static_cast<uint32_t>(data.meshes.size());
+    header.textureCount = static_cast<uint32_t>(data.texturePaths.size());
+    header.lodCount = static_cast<uint32_t>(data.lods.size());
+    header.vertexCount = data.vertices.size();
+    header.indexCount = data.indices.size();
+
+    std::vector<CookedTexture> textures;
+    std::string strings;
+    for (size_t i = 0; i < data.texturePaths.size(); i++) {
+        CookedTexture ct;
+        ct.typeOffset = static_cast<uint32_t>(strings.size());
+        ct.typeLength = static_cast<uint32_t>(data.textureTypes[i].size());
+        strings += data.textureTypes[i];
+        ct.pathOffset = static_cast<uint32_t>(strings.size());
+        ct.pathLength = static_cast<uint32_t>(data.texturePaths[i].size());
+        strings += data.texturePaths[i];
+        textures.push_back(ct);
+    }
+    Box all = emptyBox();
+    for (const CookedMesh& m : data.meshes) {
+        if (!m.vertexCount) continue;
+        growBox(all, glm::vec3(m.boundsMin[0], m.boundsMin[1], m.boundsMin[2]));
+        growBox(all, glm::vec3(m.boundsMax[0], m.boundsMax[1], m.boundsMax[2]));
+    }
+    for (int k = 0; k < 3; k++) {
+        header.boundsMin[k] = data.vertices.empty() ? 0.0f : all.min[k];
+        header.boundsMax[k] = data.vertices.empty() ? 0.0f : all.max[k];
+    }
+    header.acmr[0] = static_cast<float>(data.cacheBefore.acmr());
+    header.acmr[1] = static_cast<float>(data.cacheAfter.acmr());
+    header.atvr[0] = static_cast<float>(data.cacheBefore.atvr());
+    header.atvr[1] = static_cast<float>(data.cacheAfter.atvr());
+
+    auto align16 = [](uint64_t x) { return (x + 15) & ~uint64_t(15); };
+    header.meshOffset = sizeof(ModelCacheHeader);
+    header.lodOffset = header.meshOffset + data.meshes.size() * sizeof(CookedMesh);
+    header.textureOffset = header.lodOffset + data.lods.size() * sizeof(CookedLod);
+    header.stringOffset = header.textureOffset + textures.size() * sizeof(CookedTexture);
+    header.vertexOffset = align16(header.stringOffset + strings.size());
+    header.indexOffset = align16(header.vertexOffset + header.vertexCount * sizeof(Vertex));
+    header.fileSize = header.indexOffset + header.indexCount * sizeof(uint32_t);
+
+    std::vector<unsigned char> blob(static_cast<size_t>(header.fileSize), 0); // zeroed alignment padding
+    auto put = [&blob](uint64_t offset, const void* p, size_t bytes) {
+        if (bytes) std::memcpy(blob.data() + offset, p, bytes);
+    };
+    put(0, &header, sizeof(header));
+    put(header.meshOffset, data.meshes.data(), data.meshes.size() * sizeof(CookedMesh));
+    put(header.lodOffset, data.lods.data(), data.lods.size() * sizeof(CookedLod));
+    put(header.textureOffset, textures.data(), textures.size() * sizeof(CookedTexture));
+    put(header.stringOffset, strings.data(), strings.size());
+    put(header.vertexOffset, data.vertices.data(), data.vertices.size() * sizeof(Vertex));
+    put(header.indexOffset, data.indices.data(), data.indices.size() * sizeof(uint32_t));
+    return blob;
+}
+
+// write a cooked blob to cachePath; through a temporary file first so an
+// interrupted run never leaves a half cache behind
+inline bool writeModelCache(const std::vector<unsigned char>& blob, const std::string& cachePath)
+{
+    std::string tempPath = cachePath + ".tmp";
+    FILE* f = std::fopen(tempPath.c_str(), "wb");
+    if (!f) return false;
+    bool ok = std::fwrite(blob.data(), 1, blob.size(), f) == blob.size();
+    ok = std::fclose(f) == 0 && ok;
+    if (!ok) {
+        std::remove(tempPath.c_str());
+        return false;
+    }
+    std::remove(cachePath.c_str()); // rename doesn't replace on Windows
+    return std::rename(tempPath.c_str(), cachePath.c_str()) == 0;
+}
+
+// the model at sourcePath, cooked: from its cache when that's current, otherwise
+// imported, optimized, simplified, cooked and (best effort) saved; no GL calls
+inline bool loadCookedModel(const std::string& sourcePath, CookedModel& cooked, bool& fromCache)
+{
+    std::string cachePath = modelCachePath(sourcePath);
+    fromCache = cooked.open(cachePath, sourcePath);
+    if (fromCache) return true;
+    ModelData data;
+    if (!importModel(sourcePath, data)) return false;
+    optimizeModelData(data);
+    buildModelLods(data);
+    std::vector<unsigned char> blob = cookModel(data, hashModelSource(sourcePath));
+    if (!writeModelCache(blob, cachePath)) std::cerr << "Warning: can't write model cache " << cachePath << "\n";
+    return cooked.adopt(std::move(blob), sourcePath);
+}
+
+#endif
@@ -0,0 +1,284 @@
+#ifndef OBSTACLE_BVH_H
+#define OBSTACLE_BVH_H
+
+#include <glm/glm.hpp>
+
+#include "collision.h"
+#include "box_soa.h"
+#include "frustum_culling.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+// Static bounding-volume hierarchy over the obstacle boxes.
+// Built once with a binned surface-area heuristic (SAH) after the level is
+// created; the boxes are copied in leaf order into a BoxSoA so a leaf is a
+// contiguous run the SIMD kernel can test in one go.
+class ObstacleBVH {
+public:
+    struct Node {
+        Box bounds;
+        uint32_t leftOrFirst; // inner node: index of left child (right = left + 1), leaf: first box
+        uint32_t count;       // 0 for inner nodes
+    };
+
+    // (re)build the tree over boxes
+    void build(const std::vector<Box>& boxes)
+    {
+        nodes.clear();
+        leafBoxes.clear();
+        ids.resize(boxes.size());
+        for (uint32_t i = 0; i < ids.size(); i++) ids[i] = i;
+        if (boxes.empty()) return;
+
+        centroids.resize(boxes.size());
+        for (size_t i = 0; i < boxes.size(); i++) centroids[i] = boxCenter(boxes[i]);
+
+        nodes.reserve(boxes.size() * 2);
+        nodes.push_back({ emptyBox(), 0, static_cast<uint32_t>(boxes.size()) });
+        updateBounds(0, boxes);
+        subdivide(0, boxes, 0);
+
+        for (size_t i = 0; i < ids.size(); i++) leafBoxes.push(boxes[ids[i]]);
+        centroids.clear();
+        centroids.shrink_to_fit();
+    }
+
+    bool empty() const { return nodes.empty(); }
+    size_t nodeCount() const { return nodes.size(); }
+
+    // true if the sphere overlaps any box (same test as sphereIntersectsAABB)
+    bool anyOverlap(const glm::vec3& center, float radius) const
+    {
+        if (nodes.empty()) return false;
+        uint32_t stack[64];
+        int sp = 0;
+        stack[sp++] = 0;
+        while (sp > 0) {
+            const Node& n = nodes[stack[--sp]];
+            if (!sphereIntersectsAABB(center, radius, n.bounds)) continue;
+            if (n.count > 0) {
+                if (sphereOverlapsAny(leafBoxes, n.leftOrFirst, n.count, center, radius)) return true;
+            }
+            else {
+                stack[sp++] = n.leftOrFirst;
+                stack[sp++] = n.leftOrFirst + 1;
+            }
+        }
+        return false;
+    }
+
+    // append the ids (indices into the source vector) of every box overlapping bounds
+    void query(const Box& bounds, std::vector<uint32_t>& out) const
+    {
+        if (nodes.empty()) return;
+        uint32_t stack[64];
+        int sp = 0;
+        stack[sp++] = 0;
+        while (sp > 0) {
+            const Node& n = nodes[stack[--sp]];
+            if (!boxesOverlap(bounds, n.bounds)) continue;
+            if (n.count > 0) {
+                for (uint32_t i = 0; i < n.count; i++)
+                    if (boxesOverlap(bounds, leafBoxes.get(n.leftOrFirst + i))) out.push_back(ids[n.leftOrFirst + i]);
+            }
+            else {
+                stack[sp++] = n.leftOrFirst;
+                stack[sp++] = n.leftOrFirst + 1;
+            }
+        }
+    }
+
+    // append the ids of every box (possibly) inside the frustum. A node fully in
+    // front of a plane hands that plane's bit down, so its subtree skips it;
+    // subtrees inside all planes are taken without any further test.
+    void frustumQuery(const Frustum& f, std::vector<uint32_t>& out) const
+    {
+        if (nodes.empty()) return;
+        struct Entry {
+            uint32_t node;
+            uint32_t planeMask; // planes still to test
+        };
+        Entry stack[64];
+        int sp = 0;
+        stack[sp++] = { 0, 0x3f };
+        while (sp > 0) {
+            Entry e = stack[--sp];
+            const Node& n = nodes[e.node];
+            uint32_t mask = e.planeMask;
+            bool outside = false;
+            for (int k = 0; k < 6 && !outside; k++) {
+                if (!(mask & (1u << k))) continue;
+                const glm::vec4& p = f.planes[k];
+                if (planePositiveDistance(p, n.bounds) < 0.0f) outside = true;
+                else if (planePositiveDistance(-p, n.bounds) < 0.0f) mask &= ~(1u << k); // fully in front
+            }
+            if (outside) continue;
+            if (n.count > 0) {
+                if (mask == 0) {
+                    for (uint32_t i = 0; i < n.count; i++) out.push_back(ids[n.leftOrFirst + i]);
+                    continue;
+                }
+                uint8_t visible[MAX_LEAF_SIZE];
+                for (uint32_t done = 0; done < n.count; done += MAX_LEAF_SIZE) {
+                    uint32_t chunk = std::min(MAX_LEAF_SIZE, n.count - done);
+                    frustumCullBoxes(leafBoxes, n.leftOrFirst + done, chunk, f, visible);
+                    for (uint32_t i = 0; i < chunk; i++)
+                        if (visible[i]) out.push_back(ids[n.leftOrFirst + done + i]);
+                }
+            }
+            else {
+                stack[sp++] = { n.leftOrFirst, mask };
+                stack[sp++] = { n.leftOrFirst + 1, mask };
+            }
+        }
+    }
+
+    // true if the segment o + t*d, t in [0, 1], passes through the inside of any
+    // box; running along a face or edge doesn't count (visibility rays). A zero
+    // d tests whether the point o is inside a box. blocker gets the id of the box.
+    bool segmentBlocked(const glm::vec3& o, const glm::vec3& d, uint32_t* blocker = nullptr) const
+    {
+        if (nodes.empty()) return false;
+        uint32_t stack[64];
+        int sp = 0;
+        stack[sp++] = 0;
+        while (sp > 0) {
+            const Node& n = nodes[stack[--sp]];
+            if (!segmentOverlapsAABB(o, d, n.bounds.min, n.bounds.max)) continue;
+            if (n.count > 0) {
+                for (uint32_t i = 0; i < n.count; i++) {
+                    if (!segmentCrossesAABBInside(o, d, leafBoxes.get(n.leftOrFirst + i), INSIDE_EPSILON)) continue;
+                    if (blocker) *blocker = ids[n.leftOrFirst + i];
+                    return true;
+                }
+            }
+            else {
+                stack[sp++] = n.leftOrFirst;
+                stack[sp++] = n.leftOrFirst + 1;
+            }
+        }
+        return false;
+    }
+
+    const std::vector<Node>& getNodes() const { return nodes; }
+    // leaf slot -> index in the source vector (leaves cover [leftOrFirst, leftOrFirst + count))
+    uint32_t leafId(uint32_t slot) const { return ids[slot]; }
+
+    static constexpr float INSIDE_EPSILON = 1e-3f; // how far in from a face counts as inside
+
+private:
+    static const int BIN_COUNT = 16;
+    static const uint32_t MAX_LEAF_SIZE = 8;  // one AVX2 block
+    static const uint32_t LEAF_BATCH = 8;     // boxes the kernel tests per step
+    static const int MAX_DEPTH = 60; // traversal stacks hold 64 entries
+
+    std::vector<Node> nodes;
+    BoxSoA leafBoxes;              // boxes in leaf order
+    std::vector<uint32_t> ids;     // leaf order -> index in the source vector
+    std::vector<glm::vec3> centroids; // build-time only, indexed by source id
+
+    void updateBounds(uint32_t nodeIdx, const std::vector<Box>& boxes)
+    {
+        Node& n = nodes[nodeIdx];
+        n.bounds = emptyBox();
+        for (uint32_t i = 0; i < n.count; i++) growBox(n.bounds, boxes[ids[n.leftOrFirst + i]]);
+    }
+
+    // leaves are tested LEAF_BATCH boxes at a time, so cost them in batches
+    static float leafTests(uint32_t count) { return static_cast<float>((count + LEAF_BATCH - 1) / LEAF_BATCH); }
+
+    // binned SAH: returns the best split cost, or a huge value if no split helps
+    float findBestSplit(const Node& n, const std::vector<Box>& boxes, int& bestAxis, float& bestPos) const
+    {
+        Box centroidBounds = emptyBox();
+        for (uint32_t i = 0; i < n.count; i++) growBox(centroidBounds, centroids[ids[n.leftOrFirst + i]]);
+
+        float bestCost = 1e30f;
+        for (int axis = 0; axis < 3; axis++) {
+            float lo = centroidBounds.min[axis], hi = centroidBounds.max[axis];
+            if (hi - lo < 1e-6f) continue;
+
+            Box binBounds[BIN_COUNT];
+            uint32_t binCount[BIN_COUNT] = {};
+            for (int b = 0; b < BIN_COUNT; b++) binBounds[b] = emptyBox();
+            float scale = BIN_COUNT / (hi - lo);
+            for (uint32_t i = 0; i < n.count; i++) {
+                uint32_t id = ids[n.leftOrFirst + i];
+                int b = std::min(BIN_COUNT - 1, static_cast<int>((centroids[id][axis] - lo) * scale));
+                binCount[b]++;
+                growBox(binBounds[b], boxes[id]);
+            }
+
+            // sweep from both sides to get the area/count on each side of every plane
+            float leftArea[BIN_COUNT - 1], rightArea[BIN_COUNT - 1];
+            uint32_t leftCount[BIN_COUNT - 1], rightCount[BIN_COUNT - 1];
+            Box leftBox = emptyBox(), rightBox = emptyBox();
+            uint32_t leftSum = 0, rightSum = 0;
+            for (int b = 0; b < BIN_COUNT - 1; b++) {
+                leftSum += binCount[b];
+                leftCount[b] = leftSum;
+                growBox(leftBox, binBounds[b]);
+                leftArea[b] = boxSurfaceArea(leftBox);
+                rightSum += binCount[BIN_COUNT - 1 - b];
+                rightCount[BIN_COUNT - 2 - b] = rightSum;
+                growBox(rightBox, binBounds[BIN_COUNT - 1 - b]);
+                rightArea[BIN_COUNT - 2 - b] = boxSurfaceArea(rightBox);
+            }
+            for (int b = 0; b < BIN_COUNT - 1; b++) {
+                if (leftCount[b] == 0 || rightCount[b] == 0) continue;
+                float cost = leafTests(leftCount[b]) * leftArea[b] + leafTests(rightCount[b]) * rightArea[b];
+                if (cost < bestCost) {
+                    bestCost = cost;
+                    bestAxis = axis;
+                    bestPos = lo + (b + 1) / scale;
+                }
+            }
+        }
+        return bestCost;
+    }
+
+    void subdivide(uint32_t nodeIdx, const std::vector<Box>& boxes, int depth)
+    {
+        Node& n = nodes[nodeIdx];
+        if (n.count <= 2 || depth >= MAX_DEPTH) return;
+
+        int axis = 0;
+        float splitPos = 0.0f;
+        float splitCost = findBestSplit(n, boxes, axis, splitPos);
+        if (splitCost >= 1e30f) return; // all centroids coincide, nothing to split on
+        // one node test costs about one leaf batch
+        float area = boxSurfaceArea(n.bounds);
+        float leafCost = leafTests(n.count) * area;
+        if (splitCost + area >= leafCost && n.count <= MAX_LEAF_SIZE) return;
+
+        // partition ids around the split plane
+        uint32_t first = n.leftOrFirst;
+        uint32_t i = first;
+        uint32_t j = first + n.count - 1;
+        while (i <= j) {
+            if (centroids[ids[i]][axis] < splitPos) i++;
+            else {
+                std::swap(ids[i], ids[j]);
+                if (j == 0) break;
+                j--;
+            }
+        }
+        uint32_t leftCount = i - first;
+        if (leftCount == 0 || leftCount == n.count) return;
+
+        uint32_t leftIdx = static_cast<uint32_t>(nodes.size());
+        nodes.push_back({ emptyBox(), first, leftCount });
+        nodes.push_back({ emptyBox(), i, nodes[nodeIdx].count - leftCount });
+        // push_back may have reallocated, so index instead of holding the reference
+        nodes[nodeIdx].leftOrFirst = leftIdx;
+        nodes[nodeIdx].count = 0;
+        updateBounds(leftIdx, boxes);
+        updateBounds(leftIdx + 1, boxes);
+        subdivide(leftIdx, boxes, depth + 1);
+        subdivide(leftIdx + 1, boxes, depth + 1);
+    }
+};
+
+#endif
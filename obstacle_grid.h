@@ -0,0 +1,160 @@
+#ifndef OBSTACLE_GRID_H
+#define OBSTACLE_GRID_H
+
+#include <glm/glm.hpp>
+
+#include "collision.h"
+#include "box_soa.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+// Hashed uniform grid over the XZ plane. Every box is registered in each cell
+// its XZ footprint covers; insert/remove/update only touch those cells, so
+// moving blockers can be added at runtime without rebuilding anything.
+// Each cell keeps its boxes in a BoxSoA next to the id list for the SIMD kernel.
+class ObstacleGrid {
+public:
+    // cellSize <= 0 picks one from the average box footprint
+    void build(const std::vector<Box>& source, float cellSize = 0.0f)
+    {
+        cells.clear();
+        boxes.clear();
+        refs.clear();
+        this->cellSize = cellSize > 0.0f ? cellSize : chooseCellSize(source);
+        invCellSize = 1.0f / this->cellSize;
+        for (uint32_t id = 0; id < source.size(); id++) insert(id, source[id]);
+    }
+
+    // register box under id (ids are indices into the obstacle vector)
+    void insert(uint32_t id, const Box& b)
+    {
+        if (id >= boxes.size()) {
+            boxes.resize(id + 1);
+            refs.resize(id + 1);
+        }
+        boxes[id] = b;
+        refs[id].clear();
+        int x0, z0, x1, z1;
+        cellRange(b, x0, z0, x1, z1);
+        for (int cz = z0; cz <= z1; cz++) {
+            for (int cx = x0; cx <= x1; cx++) {
+                uint64_t key = cellKey(cx, cz);
+                Cell& cell = cells[key];
+                refs[id].push_back({ key, static_cast<uint32_t>(cell.slots.size()) });
+                cell.slots.push_back({ id, static_cast<uint32_t>(refs[id].size() - 1) });
+                cell.soa.push(b);
+            }
+        }
+    }
+
+    // unregister id; swap-and-pop inside each cell keeps this O(cells covered)
+    void remove(uint32_t id)
+    {
+        if (id >= refs.size()) return;
+        for (const CellRef& r : refs[id]) {
+            auto it = cells.find(r.key);
+            if (it == cells.end()) continue;
+            Cell& cell = it->second;
+            Slot moved = cell.slots.back();
+            cell.slots[r.slot] = moved;
+            refs[moved.id][moved.ref].slot = r.slot;
+            cell.slots.pop_back();
+            cell.soa.removeSwap(r.slot);
+            if (cell.slots.empty()) cells.erase(it);
+        }
+        refs[id].clear();
+    }
+
+    void update(uint32_t id, const Box& b)
+    {
+        remove(id);
+        insert(id, b);
+    }
+
+    // true if the sphere overlaps any box in the cells it touches
+    bool anyOverlap(const glm::vec3& center, float radius) const
+    {
+        int x0, z0, x1, z1;
+        cellRange(sphereBounds(center, radius), x0, z0, x1, z1);
+        for (int cz = z0; cz <= z1; cz++) {
+            for (int cx = x0; cx <= x1; cx++) {
+                auto it = cells.find(cellKey(cx, cz));
+                if (it == cells.end()) continue;
+                const Cell& cell = it->second;
+                if (sphereOverlapsAny(cell.soa, 0, cell.soa.size(), center, radius)) return true;
+            }
+        }
+        return false;
+    }
+
+    // append the ids of every box overlapping bounds, each id at most once.
+    // const and scratch-free, so any number of threads can query at the same time
+    void query(const Box& bounds, std::vector<uint32_t>& out) const
+    {
+        size_t start = out.size();
+        int x0, z0, x1, z1;
+        cellRange(bounds, x0, z0, x1, z1);
+        for (int cz = z0; cz <= z1; cz++) {
+            for (int cx = x0; cx <= x1; cx++) {
+                auto it = cells.find(cellKey(cx, cz));
+                if (it == cells.end()) continue;
+                for (const Slot& s : it->second.slots)
+                    if (boxesOverlap(bounds, boxes[s.id])) out.push_back(s.id);
+            }
+        }
+        // boxes spanning several cells were found once per cell
+        if (x0 != x1 || z0 != z1) {
+            std::sort(out.begin() + start, out.end());
+            out.erase(std::unique(out.begin() + start, out.end()), out.end());
+        }
+    }
+
+    float getCellSize() const { return cellSize; }
+    size_t cellCount() const { return cells.size(); }
+
+private:
+    struct Slot { uint32_t id; uint32_t ref; };     // entry in a cell, ref = index into refs[id]
+    struct CellRef { uint64_t key; uint32_t slot; }; // where an id sits inside one cell
+    struct Cell {
+        std::vector<Slot> slots;
+        BoxSoA soa; // same order as slots
+    };
+
+    float cellSize = 4.0f;
+    float invCellSize = 0.25f;
+    std::unordered_map<uint64_t, Cell> cells;
+    std::vector<Box> boxes;                  // by id
+    std::vector<std::vector<CellRef>> refs;  // by id
+
+    static uint64_t cellKey(int cx, int cz)
+    {
+        return (static_cast<uint64_t>(static_cast<uint32_t>(cx)) << 32) | static_cast<uint32_t>(cz);
+    }
+
+    void cellRange(const Box& b, int& x0, int& z0, int& x1, int& z1) const
+    {
+        x0 = static_cast<int>(std::floor(b.min.x * invCellSize));
+        z0 = static_cast<int>(std::floor(b.min.z * invCellSize));
+        x1 = static_cast<int>(std::floor(b.max.x * invCellSize));
+        z1 = static_cast<int>(std::floor(b.max.z * invCellSize));
+    }
+
+    // walls are long and thin, so size cells on the short side of the footprint
+    static float chooseCellSize(const std::vector<Box>& source)
+    {
+        if (source.empty()) return 4.0f;
+        double sum = 0.0;
+        for (const Box& b : source) {
+            glm::vec3 e = b.max - b.min;
+            sum += std::min(e.x, e.z);
+        }
+        float size = static_cast<float>(4.0 * sum / source.size());
+        return std::max(1.0f, std::min(16.0f, size));
+    }
+};
+
+#endif
@@ -0,0 +1,301 @@
+#ifndef OCCLUSION_CULLER_H
+#define OCCLUSION_CULLER_H
+
+#include <glm/glm.hpp>
+
+#include "collision.h"
+#include "box_soa.h"
+#include "worker_pool.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// CPU occlusion culling against a small software depth buffer.
+// Each frame the nearest large occluder boxes are rasterized (front faces, near
+// plane clipped) into a low-resolution buffer that keeps the closest depth per
+// pixel. Rows are split into bands across the worker pool and each band fills
+// four pixels per step with SSE. A min/max depth pyramid is then built on top, and
+// a box is occluded when the nearest point of its screen rectangle is behind
+// the farthest occluder depth under that rectangle. Coarse levels decide most
+// boxes; texels that are neither fully in front nor fully behind are refined on
+// the level below.
+//
+// Depth is NDC z mapped to [0, 1]. Occluder edges are sampled at pixel centres,
+// so something peeking out by less than one buffer pixel can be culled.
+class OcclusionCuller {
+public:
+    explicit OcclusionCuller(int width = 256, int height = 192)
+        : width((std::max(width, 4) + 3) & ~3), height(std::max(height, 1))
+    {
+        depth.assign(static_cast<size_t>(this->width) * this->height, 1.0f);
+        int w = this->width, h = this->height;
+        while (true) {
+            levels.push_back({ w, h, std::vector<float>(static_cast<size_t>(w) * h), std::vector<float>(static_cast<size_t>(w) * h) });
+            if (w == 1 && h == 1) break;
+            w = (w + 1) / 2;
+            h = (h + 1) / 2;
+        }
+    }
+
+    // start a frame: clear the buffer and the occluder list
+    void beginFrame(const glm::mat4& viewProj, const glm::vec3& eye)
+    {
+        this->viewProj = viewProj;
+        this->eye = eye;
+        triangles.clear();
+        occluders = 0;
+        std::fill(depth.begin(), depth.end(), 1.0f);
+    }
+
+    // queue up to maxOccluders of boxes[ids[i]] as occluders, biggest on screen first
+    // (largest face area over squared distance)
+    void addOccluders(const std::vector<Box>& boxes, const uint32_t* ids, size_t count, size_t maxOccluders)
+    {
+        scored.clear();
+        for (size_t i = 0; i < count; i++) {
+            const Box& b = boxes[ids[i]];
+            glm::vec3 size = b.max - b.min;
+            float area = std::max(size.x * size.y, std::max(size.y * size.z, size.x * size.z));
+            glm::vec3 nearest = glm::clamp(eye, b.min, b.max);
+            float distSq = glm::dot(nearest - eye, nearest - eye);
+            scored.push_back({ area / std::max(distSq, 1.0f), ids[i] });
+        }
+        if (scored.size() > maxOccluders) {
+            std::nth_element(scored.begin(), scored.begin() + maxOccluders, scored.end(),
+                             [](const Scored& a, const Scored& b) { return a.score > b.score; });
+            scored.resize(maxOccluders);
+        }
+        for (const Scored& s : scored) addOccluder(boxes[s.id]);
+    }
+
+    // the faces of b turned towards the eye, clipped to the near plane
+    void addOccluder(const Box& b)
+    {
+        occluders++;
+        for (int axis = 0; axis < 3; axis++) {
+            for (int side = 0; side < 2; side++) {
+                float plane = side ? b.max[axis] : b.min[axis];
+                if (side ? eye[axis] <= plane : eye[axis] >= plane) continue; // back face
+                int u = (axis + 1) % 3, v = (axis + 2) % 3;
+                glm::vec4 quad[4];
+                for (int k = 0; k < 4; k++) {
+                    glm::vec3 p;
+                    p[axis] = plane;
+                    p[u] = (k == 1 || k == 2) ? b.max[u] : b.min[u];
+                    p[v] = (k >= 2) ? b.max[v] : b.min[v];
+                    quad[k] = viewProj * glm::vec4(p, 1.0f);
+                }
+                addClippedPolygon(quad, 4);
+            }
+        }
+    }
+
+    // fill the depth buffer with the queued occluders and build the pyramid
+    void rasterize(WorkerPool* pool = nullptr)
+    {
+        size_t bands = static_cast<size_t>((height + BAND_ROWS - 1) / BAND_ROWS);
+        auto run = [&](size_t begin, size_t end) {
+            for (size_t band = begin; band < end; band++) {
+                int y0 = static_cast<int>(band) * BAND_ROWS;
+                int y1 = std::min(height, y0 + BAND_ROWS);
+                for (const ScreenTriangle& t : triangles) rasterizeTriangle(t, y0, y1);
+            }
+        };
+        if (pool && !triangles.empty()) pool->parallelFor(bands, 1, run);
+        else run(0, bands);
+        buildPyramid();
+    }
+
+    // false if b is certainly hidden behind the rasterized occluders; boxes
+    // crossing the near plane or off the buffer are left to the frustum test
+    bool boxVisible(const Box& b) const
+    {
+        float x0 = 1e30f, y0 = 1e30f, x1 = -1e30f, y1 = -1e30f, zMin = 1e30f;
+        for (int c = 0; c < 8; c++) {
+            glm::vec4 p = viewProj * glm::vec4((c & 1) ? b.max.x : b.min.x, (c & 2) ? b.max.y : b.min.y, (c & 4) ? b.max.z : b.min.z, 1.0f);
+            if (p.z < -p.w) return true;
+            float inv = 1.0f / p.w;
+            float sx = (p.x * inv * 0.5f + 0.5f) * width, sy = (p.y * inv * 0.5f + 0.5f) * height;
+            x0 = std::min(x0, sx);
+            x1 = std::max(x1, sx);
+            y0 = std::min(y0, sy);
+            y1 = std::max(y1, sy);
+            zMin = std::min(zMin, p.z * inv * 0.5f + 0.5f);
+        }
+        int px0 = std::max(0, static_cast<int>(std::floor(x0))), px1 = std::min(width - 1, static_cast<int>(std::floor(x1)));
+        int py0 = std::max(0, static_cast<int>(std::floor(y0))), py1 = std::min(height - 1, static_cast<int>(std::floor(y1)));
+        if (px0 > px1 || py0 > py1) return true;
+
+        // start on the level where the rectangle spans at most two texels per axis
+        int level = 0;
+        while (level + 1 < static_cast<int>(levels.size()) && ((px1 >> level) - (px0 >> level) > 1 || (py1 >> level) - (py0 >> level) > 1))
+            level++;
+        return rectVisible(level, px0, py0, px1, py1, zMin);
+    }
+
+    size_t occluderCount() const { return occluders; }
+    size_t triangleCount() const { return triangles.size(); }
+    int bufferWidth() const { return width; }
+    int bufferHeight() const { return height; }
+
+private:
+    static const int BAND_ROWS = 8; // rows per rasterization job
+
+    struct ScreenTriangle {
+        float x[3], y[3], z[3]; // buffer pixels, depth in [0, 1]
+    };
+    struct Level {
+        int w, h;
+        std::vector<float> minZ, maxZ;
+    };
+    struct Scored {
+        float score;
+        uint32_t id;
+    };
+
+    int width, height;
+    glm::mat4 viewProj = glm::mat4(1.0f);
+    glm::vec3 eye = glm::vec3(0.0f);
+    std::vector<float> depth; // closest occluder depth per pixel, row 0 at the bottom
+    std::vector<Level> levels;
+    std::vector<ScreenTriangle> triangles;
+    std::vector<Scored> scored;
+    size_t occluders = 0;
+
+    // Sutherland-Hodgman against z >= -w, then a fan of screen-space triangles
+    void addClippedPolygon(const glm::vec4* in, int count)
+    {
+        glm::vec4 clipped[8];
+        int n = 0;
+        for (int i = 0; i < count; i++) {
+            const glm::vec4& a = in[i];
+            const glm::vec4& b = in[(i + 1) % count];
+            float da = a.z + a.w, db = b.z + b.w;
+            if (da >= 0.0f) clipped[n++] = a;
+            if ((da >= 0.0f) != (db >= 0.0f)) clipped[n++] = a + (b - a) * (da / (da - db));
+        }
+        if (n < 3) return;
+        glm::vec3 screen[8];
+        for (int i = 0; i < n; i++) {
+            float inv = 1.0f / clipped[i].w;
+            screen[i] = glm::vec3((clipped[i].x * inv * 0.5f + 0.5f) * width, (clipped[i].y * inv * 0.5f + 0.5f) * height,
+                                  clipped[i].z * inv * 0.5f + 0.5f);
+        }
+        for (int i = 1; i + 1 < n; i++) {
+            ScreenTriangle t;
+            const glm::vec3* v[3] = { &screen[0], &screen[i], &screen[i + 1] };
+            for (int k = 0; k < 3; k++) {
+                t.x[k] = v[k]->x;
+                t.y[k] = v[k]->y;
+                t.z[k] = v[k]->z;
+            }
+            triangles.push_back(t);
+        }
+    }
+
+    // rows [y0, y1) of triangle t, keeping the smaller depth at covered pixel centres
+    void rasterizeTriangle(const ScreenTriangle& t, int y0, int y1)
+    {
+        float area = (t.x[1] - t.x[0]) * (t.y[2] - t.y[0]) - (t.x[2] - t.x[0]) * (t.y[1] - t.y[0]);
+        if (std::fabs(area) < 1e-8f) return;
+        int i1 = area > 0.0f ? 1 : 2, i2 = area > 0.0f ? 2 : 1; // counter-clockwise order
+        float vx[3] = { t.x[0], t.x[i1], t.x[i2] }, vy[3] = { t.y[0], t.y[i1], t.y[i2] };
+        area = std::fabs(area);
+
+        int minX = std::max(0, static_cast<int>(std::floor(std::min(vx[0], std::min(vx[1], vx[2])))));
+        int maxX = std::min(width - 1, static_cast<int>(std::ceil(std::max(vx[0], std::max(vx[1], vx[2])))));
+        int minY = std::max(y0, static_cast<int>(std::floor(std::min(vy[0], std::min(vy[1], vy[2])))));
+        int maxY = std::min(y1 - 1, static_cast<int>(std::ceil(std::max(vy[0], std::max(vy[1], vy[2])))));
+        if (minX > maxX || minY > maxY) return;
+
+        // edge i runs from vertex i to i + 1: e = a * x + b * y + c, >= 0 inside
+        float ea[3], eb[3], ec[3];
+        for (int i = 0; i < 3; i++) {
+            int j = (i + 1) % 3;
+            ea[i] = vy[i] - vy[j];
+            eb[i] = vx[j] - vx[i];
+            ec[i] = -(ea[i] * vx[i] + eb[i] * vy[i]);
+        }
+        // depth plane z = za * x + zb * y + zc (NDC z is affine in screen space)
+        float z0 = t.z[0], z1 = t.z[i1], z2 = t.z[i2];
+        float za = ((z1 - z0) * (vy[2] - vy[0]) - (z2 - z0) * (vy[1] - vy[0])) / area;
+        float zb = ((vx[1] - vx[0]) * (z2 - z0) - (vx[2] - vx[0]) * (z1 - z0)) / area;
+        float zc = z0 - za * vx[0] - zb * vy[0];
+
+        int startX = minX & ~3; // width is a multiple of 4, so every 4-pixel step stays in the row
+        for (int y = minY; y <= maxY; y++) {
+            float cy = y + 0.5f;
+            float* row = depth.data() + static_cast<size_t>(y) * width;
+#if BOX_SOA_X86
+            const __m128 laneX = _mm_setr_ps(0.5f, 1.5f, 2.5f, 3.5f);
+            const __m128 zero = _mm_setzero_ps();
+            __m128 rowE[3];
+            for (int i = 0; i < 3; i++) rowE[i] = _mm_set1_ps(eb[i] * cy + ec[i]);
+            __m128 rowZ = _mm_set1_ps(zb * cy + zc);
+            for (int x = startX; x <= maxX; x += 4) {
+                __m128 px = _mm_add_ps(_mm_set1_ps(static_cast<float>(x)), laneX);
+                __m128 inside = _mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(ea[0]), px), rowE[0]), zero);
+                inside = _mm_and_ps(inside, _mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(ea[1]), px), rowE[1]), zero));
+                inside = _mm_and_ps(inside, _mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(ea[2]), px), rowE[2]), zero));
+                if (_mm_movemask_ps(inside) == 0) continue;
+                __m128 z = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(za), px), rowZ);
+                __m128 old = _mm_loadu_ps(row + x);
+                __m128 closer = _mm_min_ps(old, z);
+                _mm_storeu_ps(row + x, _mm_or_ps(_mm_and_ps(inside, closer), _mm_andnot_ps(inside, old)));
+            }
+#else
+            for (int x = startX; x <= maxX; x++) {
+                float cx = x + 0.5f;
+                bool inside = true;
+                for (int i = 0; i < 3 && inside; i++) inside = ea[i] * cx + eb[i] * cy + ec[i] >= 0.0f;
+                if (inside) row[x] = std::min(row[x], za * cx + zb * cy + zc);
+            }
+#endif
+        }
+    }
+
+    void buildPyramid()
+    {
+        levels[0].minZ = depth;
+        levels[0].maxZ = depth;
+        for (size_t l = 1; l < levels.size(); l++) {
+            const Level& src = levels[l - 1];
+            Level& dst = levels[l];
+            for (int y = 0; y < dst.h; y++) {
+                int sy0 = y * 2, sy1 = std::min(src.h - 1, sy0 + 1);
+                for (int x = 0; x < dst.w; x++) {
+                    int sx0 = x * 2, sx1 = std::min(src.w - 1, sx0 + 1);
+                    size_t a = static_cast<size_t>(sy0) * src.w + sx0, b = static_cast<size_t>(sy0) * src.w + sx1;
+                    size_t c = static_cast<size_t>(sy1) * src.w + sx0, d = static_cast<size_t>(sy1) * src.w + sx1;
+                    size_t o = static_cast<size_t>(y) * dst.w + x;
+                    dst.minZ[o] = std::min(std::min(src.minZ[a], src.minZ[b]), std::min(src.minZ[c], src.minZ[d]));
+                    dst.maxZ[o] = std::max(std::max(src.maxZ[a], src.maxZ[b]), std::max(src.maxZ[c], src.maxZ[d]));
+                }
+            }
+        }
+    }
+
+    // level-0 pixel rectangle [px0, px1] x [py0, py1] with nearest depth zMin: a texel
+    // whose farthest depth is in front of zMin hides its part, one whose nearest
+    // depth is behind zMin shows it, anything in between is refined a level down
+    bool rectVisible(int level, int px0, int py0, int px1, int py1, float zMin) const
+    {
+        const Level& lv = levels[level];
+        for (int y = py0 >> level; y <= py1 >> level; y++) {
+            for (int x = px0 >> level; x <= px1 >> level; x++) {
+                size_t o = static_cast<size_t>(y) * lv.w + x;
+                if (zMin > lv.maxZ[o]) continue;
+                if (level == 0 || zMin <= lv.minZ[o]) return true;
+                int cx0 = std::max(px0, x << level), cx1 = std::min(px1, ((x + 1) << level) - 1);
+                int cy0 = std::max(py0, y << level), cy1 = std::min(py1, ((y + 1) << level) - 1);
+                if (rectVisible(level - 1, cx0, cy0, cx1, cy1, zMin)) return true;
+            }
+        }
+        return false;
+    }
+};
+
+#endif
@@ -0,0 +1,379 @@
+#ifndef PACKED_MODEL_H
+#define PACKED_MODEL_H
+
+#include <glad/glad.h>
+
+#include <learnopengl/shader_m.h>
+#include <learnopengl/mesh.h>
+
+#include "asset_loader.h"
+#include "collision.h"
+#include "indirect_draw.h"
+#include "model_cache.h"
+#include "vertex_quantization.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Every mesh of a cooked model (model_cache.h) in one VAO: one vertex buffer
+// and one index buffer, mesh i drawn by an indirect command with its
+// firstIndex / baseVertex. Meshes with the same textures form a bucket, and
+// each bucket is one glMultiDrawElementsIndirect instead of a bind + draw per
+// mesh. The vertex layout and texture uniform names are the same as Mesh's,
+// or, with VertexFormat::Compact, CompactVertex (vertex_quantization.h): 16
+// bytes a vertex, positions unpacked by 6.2.cubemaps.vs. Its positions are
+// quantized against the whole model's bounds rather than each mesh's, so one
+// set of dequantization uniforms covers every mesh in a multi-draw.
+// The model is streamed in over several frames (beginUpload / uploadGeometry
+// / finishUpload, driven by loadPackedModelAsync). It brings its meshes' LOD
+// chains along in the index buffer; selectLod() points each mesh's command at
+// the level to draw.
+enum class VertexFormat { Full, Compact };
+
+class PackedModel {
+public:
+    // empty buffers sized for cooked; bounds() and meshCount() are valid from here on.
+    // With compact vertices (cooked's, quantized with dequantization), those are
+    // uploaded instead of cooked's; they must stay alive until uploadGeometry is done.
+    void beginUpload(const CookedModel& cooked, const CompactVertex* compact = nullptr,
+                     const VertexDequantization& dequantization = VertexDequantization())
+    {
+        release();
+        meshes = cooked.meshCount();
+        modelBounds = cooked.bounds();
+        format = compact ? VertexFormat::Compact : VertexFormat::Full;
+        dequant = compact ? dequantization : VertexDequantization();
+        vertexSource = compact ? static_cast<const void*>(compact) : static_cast<const void*>(cooked.vertices());
+        vertexBytes = cooked.vertexCount() * (compact ? sizeof(CompactVertex) : sizeof(Vertex));
+        allocate(cooked.vertexCount(), cooked.indexCount());
+    }
+
+    // copy up to maxBytes more of the vertex then index blob; true once both are in
+    bool uploadGeometry(const CookedModel& cooked, size_t maxBytes)
+    {
+        size_t indexBytes = cooked.indexCount() * sizeof(uint32_t);
+        if (uploaded < vertexBytes) {
+            size_t n = std::min(maxBytes, vertexBytes - uploaded);
+            writeBuffer(VBO, uploaded, static_cast<const unsigned char*>(vertexSource) + uploaded, n);
+            uploaded += n;
+            maxBytes -= n;
+        }
+        if (uploaded >= vertexBytes && maxBytes > 0 && uploaded < vertexBytes + indexBytes) {
+            size_t offset = uploaded - vertexBytes;
+            size_t n = std::min(maxBytes, indexBytes - offset);
+            writeBuffer(EBO, offset, reinterpret_cast<const unsigned char*>(cooked.indices()) + offset, n);
+            uploaded += n;
+        }
+        if (uploaded < vertexBytes + indexBytes) return false;
+        vertexSource = nullptr;
+        return true;
+    }
+
+    // draw commands and texture buckets; textureIds[t] is the GL texture for cooked texture t
+    void finishUpload(const CookedModel& cooked, const std::vector<GLuint>& textureIds)
+    {
+        for (size_t i = 0; i < cooked.meshCount(); i++) {
+            const CookedMesh& mesh = cooked.mesh(i);
+            std::vector<Texture> textures;
+            for (uint32_t t = mesh.firstTexture; t < mesh.firstTexture + mesh.textureCount; t++) {
+                Texture texture;
+                texture.id = textureIds[t];
+                texture.type = cooked.textureType(t);
+                texture.path = cooked.texturePath(t);
+                textures.push_back(texture);
+            }
+            DrawElementsIndirectCommand cmd = { mesh.indexCount, 1, mesh.firstIndex, static_cast<GLint>(mesh.firstVertex), 0 };
+            std::vector<Lod> lods;
+            for (uint32_t l = mesh.firstLod; l < mesh.firstLod + mesh.lodCount; l++)
+                lods.push_back({ cooked.lod(l).firstIndex, cooked.lod(l).indexCount, cooked.lod(l).error });
+            if (lods.empty()) lods.push_back({ mesh.firstIndex, mesh.indexCount, 0.0f });
+            addDraw(textures, cmd, lods);
+        }
+        ready = true;
+    }
+
+    // every mesh is uploaded and drawable
+    bool resident() const { return ready; }
+
+    // per mesh, the coarsest level whose measured deviation projects to at most
+    // maxPixelError pixels at pixelsPerUnit (screen pixels per model unit at the
+    // model's distance); a huge pixelsPerUnit keeps every mesh at full detail
+    void selectLod(float pixelsPerUnit, float maxPixelError = 1.0f)
+    {
+        triangles = 0;
+        deepest = 0;
+        for (MeshDraw& d : draws) {
+            size_t level = 0;
+            while (level + 1 < d.lods.size() && d.lods[level + 1].error * pixelsPerUnit <= maxPixelError) level++;
+            d.level = level;
+            DrawElementsIndirectCommand& cmd = buckets[d.bucket].commands[d.command];
+            cmd.firstIndex = d.lods[level].firstIndex;
+            cmd.count = d.lods[level].indexCount;
+            triangles += cmd.count / 3;
+            deepest = std::max(deepest, level);
+        }
+    }
+
+    // triangles submitted per draw with the current levels, and the coarsest level in use
+    size_t drawnTriangles() const { return triangles; }
+    size_t lodLevel() const { return deepest; }
+
+    // all meshes, one multi-draw per bucket; false (nothing drawn) if the frame's
+    // commands are full. Every bucket's commands are written before the first
+    // draw, so a full buffer never leaves some buckets drawn.
+    bool draw(Shader& shader, IndirectCommandBuffer& commands)
+    {
+        if (!ready) return true;
+        indirectOffsets.resize(buckets.size());
+        for (size_t i = 0; i < buckets.size(); i++)
+            if (!commands.write(buckets[i].commands.data(), buckets[i].commands.size(), indirectOffsets[i])) return false;
+        setDequantization(shader);
+        glBindVertexArray(VAO);
+        commands.bind();
+        for (size_t i = 0; i < buckets.size(); i++) {
+            bindTextures(shader, buckets[i].textures);
+            commands.functions().multiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, indirectOffsets[i],
+                                                            static_cast<GLsizei>(buckets[i].commands.size()), 0);
+        }
+        glBindVertexArray(0);
+        glActiveTexture(GL_TEXTURE0);
+        return true;
+    }
+
+    // the same draws one glDrawElementsBaseVertex (GL 3.2) at a time, for contexts without multi-draw-indirect
+    void drawDirect(Shader& shader)
+    {
+        if (!ready) return;
+        setDequantization(shader);
+        glBindVertexArray(VAO);
+        for (const Bucket& b : buckets) {
+            bindTextures(shader, b.textures);
+            for (const DrawElementsIndirectCommand& c : b.commands)
+                glDrawElementsBaseVertex(GL_TRIANGLES, static_cast<GLsizei>(c.count), GL_UNSIGNED_INT,
+                                         (void*)(c.firstIndex * sizeof(unsigned int)), c.baseVertex);
+        }
+        glBindVertexArray(0);
+        glActiveTexture(GL_TEXTURE0);
+    }
+
+    size_t meshCount() const { return meshes; }
+    const Box& bounds() const { return modelBounds; }
+    size_t bucketCount() const { return buckets.size(); }
+    VertexFormat vertexFormat() const { return format; }
+    size_t vertexBufferBytes() const { return vertexBytes; }
+
+    void release()
+    {
+        if (VAO) {
+            glDeleteVertexArrays(1, &VAO);
+            glDeleteBuffers(1, &VBO);
+            glDeleteBuffers(1, &EBO);
+        }
+        VAO = VBO = EBO = 0;
+        buckets.clear();
+        draws.clear();
+        triangles = deepest = 0;
+        meshes = 0;
+        modelBounds = emptyBox();
+        uploaded = 0;
+        ready = false;
+        format = VertexFormat::Full;
+        dequant = VertexDequantization();
+        vertexSource = nullptr;
+        vertexBytes = 0;
+    }
+
+private:
+    struct Bucket {
+        std::vector<Texture> textures;
+        std::vector<DrawElementsIndirectCommand> commands;
+    };
+
+    struct Lod {
+        uint32_t firstIndex, indexCount;
+        float error;
+    };
+
+    // where a mesh's command lives, and its levels of detail
+    struct MeshDraw {
+        size_t bucket, command;
+        std::vector<Lod> lods;
+        size_t level;
+    };
+
+    unsigned int VAO = 0, VBO = 0, EBO = 0;
+    std::vector<Bucket> buckets;
+    std::vector<const void*> indirectOffsets; // draw(): where each bucket's commands went this frame
+    std::vector<MeshDraw> draws;
+    size_t triangles = 0, deepest = 0; // from the last selectLod (or full detail)
+    size_t meshes = 0;
+    Box modelBounds = emptyBox();
+    size_t uploaded = 0; // bytes of vertices + indices streamed so far
+    bool ready = false;
+    VertexFormat format = VertexFormat::Full;
+    VertexDequantization dequant;
+    const void* vertexSource = nullptr; // while streaming
+    size_t vertexBytes = 0;
+
+    void allocate(size_t vertexCount, size_t indexCount)
+    {
+        glGenVertexArrays(1, &VAO);
+        glGenBuffers(1, &VBO);
+        glGenBuffers(1, &EBO);
+        glBindVertexArray(VAO);
+        glBindBuffer(GL_ARRAY_BUFFER, VBO);
+        glBufferData(GL_ARRAY_BUFFER, vertexCount * (format == VertexFormat::Compact ? sizeof(CompactVertex) : sizeof(Vertex)),
+                     nullptr, GL_STATIC_DRAW);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, indexCount * sizeof(unsigned int), nullptr, GL_STATIC_DRAW);
+
+        if (format == VertexFormat::Compact) {
+            glEnableVertexAttribArray(0);
+            glVertexAttribPointer(0, 3, GL_UNSIGNED_SHORT, GL_TRUE, sizeof(CompactVertex), (void*)offsetof(CompactVertex, position));
+            glEnableVertexAttribArray(1);
+            glVertexAttribPointer(1, 2, GL_SHORT, GL_TRUE, sizeof(CompactVertex), (void*)offsetof(CompactVertex, normal));
+            glEnableVertexAttribArray(2);
+            glVertexAttribPointer(2, 2, GL_HALF_FLOAT, GL_FALSE, sizeof(CompactVertex), (void*)offsetof(CompactVertex, texCoords));
+            glBindVertexArray(0);
+            return;
+        }
+        glEnableVertexAttribArray(0);
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, Position));
+        glEnableVertexAttribArray(1);
+        glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, Normal));
+        glEnableVertexAttribArray(2);
+        glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, TexCoords));
+        glEnableVertexAttribArray(3);
+        glVertexAttribPointer(3, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, Tangent));
+        glEnableVertexAttribArray(4);
+        glVertexAttribPointer(4, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, Bitangent));
+        glEnableVertexAttribArray(5);
+        glVertexAttribIPointer(5, 4, GL_INT, sizeof(Vertex), (void*)offsetof(Vertex, m_BoneIDs));
+        glEnableVertexAttribArray(6);
+        glVertexAttribPointer(6, 4, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, m_Weights));
+        glBindVertexArray(0);
+    }
+
+    // through the copy-write target, so no VAO's element buffer binding changes
+    static void writeBuffer(GLuint buffer, size_t offset, const void* data, size_t bytes)
+    {
+        if (!bytes) return;
+        glBindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+        glBufferSubData(GL_COPY_WRITE_BUFFER, static_cast<GLintptr>(offset), static_cast<GLsizeiptr>(bytes), data);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+    }
+
+    size_t bucketFor(const std::vector<Texture>& textures)
+    {
+        for (size_t i = 0; i < buckets.size(); i++) {
+            const Bucket& b = buckets[i];
+            if (b.textures.size() != textures.size()) continue;
+            bool same = true;
+            for (size_t t = 0; t < textures.size() && same; t++)
+                same = b.textures[t].id == textures[t].id && b.textures[t].type == textures[t].type;
+            if (same) return i;
+        }
+        buckets.push_back({ textures, {} });
+        return buckets.size() - 1;
+    }
+
+    void addDraw(const std::vector<Texture>& textures, const DrawElementsIndirectCommand& cmd, const std::vector<Lod>& lods)
+    {
+        size_t bucket = bucketFor(textures);
+        buckets[bucket].commands.push_back(cmd);
+        draws.push_back({ bucket, buckets[bucket].commands.size() - 1, lods, 0 });
+        triangles += cmd.count / 3;
+    }
+
+    // unpacking constants for 6.2.cubemaps.vs; identity for full-float vertices
+    void setDequantization(Shader& shader) const
+    {
+        shader.setVec3("positionScale", dequant.scale);
+        shader.setVec3("positionOffset", dequant.offset);
+    }
+
+    // same unit / uniform naming as Mesh::Draw (texture_diffuse1, texture_specular1, ...)
+    static void bindTextures(Shader& shader, const std::vector<Texture>& textures)
+    {
+        unsigned int diffuseNr = 1, specularNr = 1, normalNr = 1, heightNr = 1;
+        for (unsigned int i = 0; i < textures.size(); i++) {
+            glActiveTexture(GL_TEXTURE0 + i);
+            const std::string& name = textures[i].type;
+            std::string number;
+            if (name == "texture_diffuse") number = std::to_string(diffuseNr++);
+            else if (name == "texture_specular") number = std::to_string(specularNr++);
+            else if (name == "texture_normal") number = std::to_string(normalNr++);
+            else if (name == "texture_height") number = std::to_string(heightNr++);
+            glUniform1i(glGetUniformLocation(shader.ID, (name + number).c_str()), i);
+            glBindTexture(GL_TEXTURE_2D, textures[i].id);
+        }
+    }
+};
+
+// Loads the model at sourcePath into model without blocking the render thread.
+// The loader thread gets the cooked model (loadCookedModel: cache or import)
+// and decodes its textures; the render thread then allocates the buffers, then
+// uploads one texture per step and the geometry in chunkBytes pieces, then
+// builds the draw lists. Compact vertices are quantized on the loader thread
+// too. onResident(cooked, fromCache) runs on the render thread once
+// model.resident(), with the cooked model still open.
+inline void loadPackedModelAsync(AssetLoader& loader, PackedModel& model, const std::string& sourcePath, VertexFormat format,
+                                 std::function<void(const CookedModel&, bool)> onResident, size_t chunkBytes = 4u << 20)
+{
+    struct Load {
+        CookedModel cooked;
+        bool fromCache = false;
+        std::vector<CompactVertex> compact;
+        VertexDequantization dequantization;
+        std::vector<size_t> imageOf;     // cooked texture -> images index
+        std::vector<DecodedImage> images; // one per distinct path
+        std::vector<GLuint> imageIds;
+        size_t step = 0;
+    };
+    std::shared_ptr<Load> load = std::make_shared<Load>();
+    loader.load(
+        [load, sourcePath, format] {
+            if (!loadCookedModel(sourcePath, load->cooked, load->fromCache)) return false;
+            if (format == VertexFormat::Compact)
+                load->dequantization = quantizeVertices(load->cooked.vertices(), load->cooked.vertexCount(), load->cooked.bounds(),
+                                                        load->compact);
+            std::vector<std::string> paths;
+            for (size_t t = 0; t < load->cooked.textureCount(); t++) {
+                std::string path = load->cooked.texturePath(t);
+                size_t image = std::find(paths.begin(), paths.end(), path) - paths.begin();
+                if (image == paths.size()) paths.push_back(path);
+                load->imageOf.push_back(image);
+            }
+            load->images.resize(paths.size());
+            for (size_t i = 0; i < paths.size(); i++) load->images[i].load(load->cooked.sourceDirectory() + '/' + paths[i]);
+            return true;
+        },
+        [load, &model, onResident, chunkBytes] {
+            size_t step = load->step++;
+            if (step == 0) {
+                model.beginUpload(load->cooked, load->compact.empty() ? nullptr : load->compact.data(), load->dequantization);
+                return false;
+            }
+            if (step <= load->images.size()) {
+                const DecodedImage& image = load->images[step - 1];
+                load->imageIds.push_back(image.pixels ? createTexture2D(image) : 0);
+                load->images[step - 1] = DecodedImage(); // pixels freed as soon as they're on the GPU
+                return false;
+            }
+            if (!model.uploadGeometry(load->cooked, chunkBytes)) return false;
+            std::vector<GLuint> textureIds;
+            for (size_t image : load->imageOf) textureIds.push_back(load->imageIds[image]);
+            model.finishUpload(load->cooked, textureIds);
+            if (onResident) onResident(load->cooked, load->fromCache);
+            load->cooked.close();
+            load->compact = std::vector<CompactVertex>();
+            return true;
+        });
+}
+
+#endif
@@ -0,0 +1,127 @@
+#ifndef PLATFORM_HEIGHT_GRID_H
+#define PLATFORM_HEIGHT_GRID_H
+
+#include <glm/glm.hpp>
+
+#include "collision.h"
+
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+// Platforms rasterized into a 2D grid over XZ at load time.
+// Each cell stores the highest top of the platforms that cover the whole cell,
+// plus the few platforms that only cover part of it (cells on platform edges).
+// A query is one cell lookup and an exact test against those partial
+// platforms, so it returns exactly what a scan over every platform would.
+class PlatformHeightGrid {
+public:
+    // cellSize is the target resolution; it grows if the level would need more than maxCells
+    void build(const std::vector<Box>& platforms, float cellSize = 1.0f, size_t maxCells = 1 << 22)
+    {
+        boxes = platforms;
+        fullTop.clear();
+        partialStart.clear();
+        partialIds.clear();
+        cols = rows = 0;
+        if (platforms.empty()) return;
+
+        Box bounds = emptyBox();
+        for (const Box& p : platforms) growBox(bounds, p);
+        origin = glm::vec2(bounds.min.x, bounds.min.z);
+        glm::vec2 extent(bounds.max.x - bounds.min.x, bounds.max.z - bounds.min.z);
+        extentMax = origin + extent;
+
+        size = cellSize;
+        while (true) {
+            cols = std::max(1, static_cast<int>(std::ceil(extent.x / size)));
+            rows = std::max(1, static_cast<int>(std::ceil(extent.y / size)));
+            if (static_cast<size_t>(cols) * rows <= maxCells) break;
+            size *= 2.0f;
+        }
+        invSize = 1.0f / size;
+
+        size_t cellCount = static_cast<size_t>(cols) * rows;
+        fullTop.assign(cellCount, NO_TOP);
+
+        // pass 1: full coverage tops; pass 2 (after fullTop is final): partial lists in CSR form
+        std::vector<std::vector<uint32_t>> partial(cellCount);
+        for (uint32_t id = 0; id < platforms.size(); id++) {
+            const Box& p = platforms[id];
+            int x0, z0, x1, z1;
+            cellRange(p, x0, z0, x1, z1);
+            for (int cz = z0; cz <= z1; cz++) {
+                for (int cx = x0; cx <= x1; cx++) {
+                    size_t c = static_cast<size_t>(cz) * cols + cx;
+                    if (coversCell(p, cx, cz)) fullTop[c] = std::max(fullTop[c], p.max.y);
+                    else partial[c].push_back(id);
+                }
+            }
+        }
+        partialStart.resize(cellCount + 1);
+        for (size_t c = 0; c < cellCount; c++) {
+            partialStart[c] = static_cast<uint32_t>(partialIds.size());
+            for (uint32_t id : partial[c]) {
+                // a partial platform below the full-cover top can never win
+                if (platforms[id].max.y > fullTop[c]) partialIds.push_back(id);
+            }
+        }
+        partialStart[cellCount] = static_cast<uint32_t>(partialIds.size());
+    }
+
+    // highest platform top containing (x, z), same inclusive test as the linear scan
+    bool highestTopAt(float x, float z, float& outTopY) const
+    {
+        if (cols == 0) return false;
+        if (x < origin.x || x > extentMax.x || z < origin.y || z > extentMax.y) return false;
+        int cx = std::min(cols - 1, static_cast<int>((x - origin.x) * invSize));
+        int cz = std::min(rows - 1, static_cast<int>((z - origin.y) * invSize));
+        size_t c = static_cast<size_t>(cz) * cols + cx;
+
+        float best = fullTop[c];
+        for (uint32_t i = partialStart[c]; i < partialStart[c + 1]; i++) {
+            const Box& p = boxes[partialIds[i]];
+            if (x >= p.min.x && x <= p.max.x && z >= p.min.z && z <= p.max.z && p.max.y > best) best = p.max.y;
+        }
+        if (best == NO_TOP) return false;
+        outTopY = best;
+        return true;
+    }
+
+    float getCellSize() const { return size; }
+    size_t cellCount() const { return fullTop.size(); }
+    size_t partialEntryCount() const { return partialIds.size(); }
+
+private:
+    static constexpr float NO_TOP = -1e30f;
+
+    std::vector<Box> boxes;
+    glm::vec2 origin = glm::vec2(0.0f);
+    glm::vec2 extentMax = glm::vec2(0.0f);
+    float size = 1.0f;
+    float invSize = 1.0f;
+    int cols = 0, rows = 0;
+    std::vector<float> fullTop;          // per cell, NO_TOP if nothing covers the whole cell
+    std::vector<uint32_t> partialStart;  // per cell (+1), range into partialIds
+    std::vector<uint32_t> partialIds;
+
+    void cellRange(const Box& p, int& x0, int& z0, int& x1, int& z1) const
+    {
+        x0 = std::max(0, std::min(cols - 1, static_cast<int>(std::floor((p.min.x - origin.x) * invSize))));
+        z0 = std::max(0, std::min(rows - 1, static_cast<int>(std::floor((p.min.z - origin.y) * invSize))));
+        x1 = std::max(0, std::min(cols - 1, static_cast<int>(std::floor((p.max.x - origin.x) * invSize))));
+        z1 = std::max(0, std::min(rows - 1, static_cast<int>(std::floor((p.max.z - origin.y) * invSize))));
+    }
+
+    // a cell is the closed range [origin + c*size, origin + (c+1)*size] (clipped to the bounds);
+    // the margin keeps rounding in the query's cell lookup from trusting a platform edge
+    bool coversCell(const Box& p, int cx, int cz) const
+    {
+        float eps = size * 1e-3f;
+        float x0 = origin.x + cx * size, z0 = origin.y + cz * size;
+        float x1 = std::min(extentMax.x, x0 + size), z1 = std::min(extentMax.y, z0 + size);
+        return p.min.x <= x0 - eps && p.max.x >= x1 + eps && p.min.z <= z0 - eps && p.max.z >= z1 + eps;
+    }
+};
+
+#endif
@@ -0,0 +1,228 @@
+#ifndef RENDER_QUEUE_H
+#define RENDER_QUEUE_H
+
+#include <glad/glad.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+// ---------- GL state tracking ----------
+// Remembers the program, vertex array, texture bindings and depth function
+// last set through it and drops calls that would set the same value again.
+// Code that changes these behind its back (Mesh::Draw, Shader::use, ...) must
+// call the matching invalidate so the next bind isn't skipped by mistake.
+class GLStateCache {
+public:
+    static const GLuint TEXTURE_UNITS = 16;
+
+    void useProgram(GLuint program)
+    {
+        if (program == currentProgram) { skipped++; return; }
+        glUseProgram(program);
+        currentProgram = program;
+        changes++;
+    }
+
+    void bindVertexArray(GLuint vao)
+    {
+        if (vao == currentVao) { skipped++; return; }
+        glBindVertexArray(vao);
+        currentVao = vao;
+        changes++;
+    }
+
+    void bindTexture(GLuint unit, GLenum target, GLuint texture)
+    {
+        if (unit >= TEXTURE_UNITS) {
+            glActiveTexture(GL_TEXTURE0 + unit);
+            glBindTexture(target, texture);
+            activeUnit = unit;
+            changes++;
+            return;
+        }
+        TextureBinding& b = textures[unit];
+        if (b.target == target && b.texture == texture) { skipped++; return; }
+        if (activeUnit != unit) {
+            glActiveTexture(GL_TEXTURE0 + unit);
+            activeUnit = unit;
+        }
+        glBindTexture(target, texture);
+        b.target = target;
+        b.texture = texture;
+        changes++;
+    }
+
+    void depthFunc(GLenum func)
+    {
+        if (func == currentDepthFunc) { skipped++; return; }
+        glDepthFunc(func);
+        currentDepthFunc = func;
+        changes++;
+    }
+
+    void invalidateProgram() { currentProgram = UNKNOWN; }
+    void invalidateVertexArray() { currentVao = UNKNOWN; }
+    void invalidateTextures()
+    {
+        for (TextureBinding& b : textures) b = TextureBinding();
+        activeUnit = UNKNOWN;
+    }
+    void invalidate()
+    {
+        invalidateProgram();
+        invalidateVertexArray();
+        invalidateTextures();
+        currentDepthFunc = UNKNOWN;
+    }
+
+    // state calls issued / skipped since the last resetCounters
+    size_t changeCount() const { return changes; }
+    size_t skippedCount() const { return skipped; }
+    void resetCounters() { changes = skipped = 0; }
+
+private:
+    static const GLuint UNKNOWN = 0xffffffffu;
+
+    struct TextureBinding {
+        GLenum target = UNKNOWN;
+        GLuint texture = UNKNOWN;
+    };
+
+    GLuint currentProgram = UNKNOWN;
+    GLuint currentVao = UNKNOWN;
+    GLenum currentDepthFunc = UNKNOWN;
+    GLuint activeUnit = UNKNOWN;
+    TextureBinding textures[TEXTURE_UNITS];
+    size_t changes = 0, skipped = 0;
+};
+
+// ---------- render queue ----------
+// Draws are submitted in any order as items carrying the state they need, and
+// flush() replays them sorted by a 64-bit key, so items sharing a program /
+// texture / vertex array end up next to each other and the state cache skips
+// the repeated binds. Key layout, high bits first:
+//
+//   pass (4) | program (12) | texture (16) | vertex array (12) | depth (20)
+//
+// Names wider than their field are masked; two names sharing a field value
+// only cost a few extra state changes, the binds themselves use the real names.
+// Depth orders front to back inside a state bucket (early depth rejection).
+//
+// What an item draws is a drawer registered once with addDrawer; it gets the
+// state cache and the item's param (a mesh index, a box range, ...). The
+// drawer sets its uniforms and issues the draw; the program, texture unit 0,
+// vertex array and pass depth function are already bound.
+enum class RenderPass : uint8_t {
+    Opaque = 0,
+    Sky = 1, // after the opaque pass with GL_LEQUAL, so it only fills what's left
+    Count
+};
+
+class RenderQueue {
+public:
+    typedef std::function<void(GLStateCache& state, uint32_t param)> Drawer;
+
+    struct Item {
+        RenderPass pass = RenderPass::Opaque;
+        GLuint program = 0;
+        GLuint vao = 0;          // 0 = the drawer binds its own
+        GLenum textureTarget = GL_TEXTURE_2D;
+        GLuint texture = 0;      // bound to unit 0; 0 = the drawer binds its own
+        float depth = 0.0f;      // view distance, 0 .. maxDepth
+        uint32_t drawer = 0;
+        uint32_t param = 0;
+    };
+
+    explicit RenderQueue(float maxDepth = 100.0f) : maxDepth(maxDepth) {}
+
+    uint32_t addDrawer(Drawer drawer)
+    {
+        drawers.push_back(std::move(drawer));
+        return static_cast<uint32_t>(drawers.size() - 1);
+    }
+
+    void clear()
+    {
+        items.clear();
+        keys.clear();
+    }
+
+    void submit(const Item& item)
+    {
+        keys.push_back({ makeKey(item), static_cast<uint32_t>(items.size()) });
+        items.push_back(item);
+    }
+
+    // sort and draw everything submitted since clear()
+    void flush(GLStateCache& state)
+    {
+        radixSort();
+        for (const KeyIndex& k : keys) {
+            const Item& item = items[k.index];
+            state.depthFunc(item.pass == RenderPass::Sky ? GL_LEQUAL : GL_LESS);
+            state.useProgram(item.program);
+            if (item.texture) state.bindTexture(0, item.textureTarget, item.texture);
+            if (item.vao) state.bindVertexArray(item.vao);
+            drawers[item.drawer](state, item.param);
+        }
+        state.depthFunc(GL_LESS);
+    }
+
+    size_t size() const { return items.size(); }
+
+private:
+    static const int PASS_BITS = 4, PROGRAM_BITS = 12, TEXTURE_BITS = 16, VAO_BITS = 12, DEPTH_BITS = 20;
+
+    struct KeyIndex {
+        uint64_t key;
+        uint32_t index;
+    };
+
+    float maxDepth;
+    std::vector<Drawer> drawers;
+    std::vector<Item> items;
+    std::vector<KeyIndex> keys, scratch;
+
+    static uint64_t field(uint64_t value, int bits) { return value & ((uint64_t(1) << bits) - 1); }
+
+    uint64_t makeKey(const Item& item) const
+    {
+        float t = std::min(std::max(item.depth / maxDepth, 0.0f), 1.0f);
+        uint64_t depth = static_cast<uint64_t>(t * ((1u << DEPTH_BITS) - 1));
+        uint64_t key = field(static_cast<uint64_t>(item.pass), PASS_BITS);
+        key = (key << PROGRAM_BITS) | field(item.program, PROGRAM_BITS);
+        key = (key << TEXTURE_BITS) | field(item.texture, TEXTURE_BITS);
+        key = (key << VAO_BITS) | field(item.vao, VAO_BITS);
+        key = (key << DEPTH_BITS) | depth;
+        return key;
+    }
+
+    // LSD radix sort on the keys, one byte per pass (stable, so equal keys keep
+    // submission order); bytes where every key is the same are skipped, which
+    // with few distinct states is most of them
+    void radixSort()
+    {
+        size_t n = keys.size();
+        if (n < 2) return;
+        size_t counts[8][256] = {};
+        for (const KeyIndex& k : keys)
+            for (int b = 0; b < 8; b++) counts[b][(k.key >> (b * 8)) & 0xff]++;
+        scratch.resize(n);
+        for (int b = 0; b < 8; b++) {
+            if (counts[b][(keys[0].key >> (b * 8)) & 0xff] == n) continue;
+            size_t offsets[256];
+            size_t sum = 0;
+            for (int d = 0; d < 256; d++) {
+                offsets[d] = sum;
+                sum += counts[b][d];
+            }
+            for (const KeyIndex& k : keys) scratch[offsets[(k.key >> (b * 8)) & 0xff]++] = k;
+            keys.swap(scratch);
+        }
+    }
+};
+
+#endif
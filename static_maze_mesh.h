@@ -0,0 +1,173 @@
+#ifndef STATIC_MAZE_MESH_H
+#define STATIC_MAZE_MESH_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include "collision.h"
+#include "indirect_draw.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// The static maze (platforms + obstacles) baked into world-space triangles in a
+// single VBO/IBO: no per-box matrices, uniforms or instance math at draw time.
+// Box i owns vertices [8i, 8i + 8) and indices [36i, 36i + 36), platforms first,
+// so any run of boxes is one contiguous index range.
+
+struct BakedWallVertex {
+    glm::vec3 position; // world space
+    glm::vec3 tint;
+};
+
+// CPU half of the bake (no GL): 8 corners and 12 outward-facing triangles per box
+inline void bakeBoxes(const std::vector<Box>& boxes, const glm::vec3& tint,
+                      std::vector<BakedWallVertex>& vertices, std::vector<uint32_t>& indices)
+{
+    // corner c has x from bit 0, y from bit 1, z from bit 2
+    static const uint32_t faces[36] = {
+        0, 4, 6, 0, 6, 2, // -X
+        1, 3, 7, 1, 7, 5, // +X
+        0, 1, 5, 0, 5, 4, // -Y
+        2, 6, 7, 2, 7, 3, // +Y
+        0, 2, 3, 0, 3, 1, // -Z
+        4, 5, 7, 4, 7, 6  // +Z
+    };
+    for (const Box& b : boxes) {
+        uint32_t base = static_cast<uint32_t>(vertices.size());
+        for (int c = 0; c < 8; c++) {
+            glm::vec3 p((c & 1) ? b.max.x : b.min.x, (c & 2) ? b.max.y : b.min.y, (c & 4) ? b.max.z : b.min.z);
+            vertices.push_back({ p, tint });
+        }
+        for (uint32_t i : faces) indices.push_back(base + i);
+    }
+}
+
+// call fn(first, count) for each run of consecutive ids in a sorted box list
+template <typename Fn>
+inline void forEachBoxRun(const std::vector<uint32_t>& sortedBoxes, Fn fn)
+{
+    for (size_t i = 0; i < sortedBoxes.size();) {
+        size_t j = i + 1;
+        while (j < sortedBoxes.size() && sortedBoxes[j] == sortedBoxes[j - 1] + 1) j++;
+        fn(sortedBoxes[i], static_cast<uint32_t>(j - i));
+        i = j;
+    }
+}
+
+class StaticMazeMesh {
+public:
+    static const GLsizei INDICES_PER_BOX = 36;
+
+    unsigned int VAO = 0;
+
+    // bake and upload; call again only when the level changes
+    void build(const std::vector<Box>& platforms, const std::vector<Box>& obstacles)
+    {
+        std::vector<BakedWallVertex> vertices;
+        std::vector<uint32_t> indices;
+        vertices.reserve((platforms.size() + obstacles.size()) * 8);
+        indices.reserve((platforms.size() + obstacles.size()) * INDICES_PER_BOX);
+        bakeBoxes(platforms, glm::vec3(0.9f), vertices, indices); // near-white tint for floor
+        bakeBoxes(obstacles, glm::vec3(1.0f), vertices, indices); // neutral tint (texture shows)
+        boxes = platforms.size() + obstacles.size();
+
+        if (!VAO) {
+            glGenVertexArrays(1, &VAO);
+            glGenBuffers(1, &VBO);
+            glGenBuffers(1, &EBO);
+        }
+        glBindVertexArray(VAO);
+        glBindBuffer(GL_ARRAY_BUFFER, VBO);
+        glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(BakedWallVertex), vertices.data(), GL_STATIC_DRAW);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(uint32_t), indices.data(), GL_STATIC_DRAW);
+
+        // same locations as the wall shader's aPos / iTint
+        glEnableVertexAttribArray(0);
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(BakedWallVertex), (void*)offsetof(BakedWallVertex, position));
+        glEnableVertexAttribArray(3);
+        glVertexAttribPointer(3, 3, GL_FLOAT, GL_FALSE, sizeof(BakedWallVertex), (void*)offsetof(BakedWallVertex, tint));
+        glBindVertexArray(0);
+    }
+
+    // the whole maze in one call
+    void draw() const
+    {
+        drawBoxes(0, boxes);
+    }
+
+    // boxes [first, first + count) in one call
+    void drawBoxes(size_t first, size_t count) const
+    {
+        if (count == 0) return;
+        bind();
+        glDrawElements(GL_TRIANGLES, static_cast<GLsizei>(count) * INDICES_PER_BOX, GL_UNSIGNED_INT,
+                       (void*)(first * INDICES_PER_BOX * sizeof(uint32_t)));
+    }
+
+    // a sorted list of boxes (e.g. the ones that survived culling): runs of
+    // consecutive boxes become one index range, all ranges go out in one call
+    void drawBoxList(const std::vector<uint32_t>& sortedBoxes)
+    {
+        rangeCounts.clear();
+        rangeOffsets.clear();
+        forEachBoxRun(sortedBoxes, [&](uint32_t first, uint32_t count) {
+            rangeCounts.push_back(static_cast<GLsizei>(count) * INDICES_PER_BOX);
+            rangeOffsets.push_back((const void*)(first * INDICES_PER_BOX * sizeof(uint32_t)));
+        });
+        if (rangeCounts.empty()) return;
+        bind();
+        glMultiDrawElements(GL_TRIANGLES, rangeCounts.data(), GL_UNSIGNED_INT, rangeOffsets.data(),
+                            static_cast<GLsizei>(rangeCounts.size()));
+    }
+
+    // the same runs written as indirect commands and drawn with one
+    // glMultiDrawElementsIndirect; false (nothing drawn) if the frame's commands are full
+    bool drawBoxListIndirect(const std::vector<uint32_t>& sortedBoxes, IndirectCommandBuffer& commands)
+    {
+        const GLuint perBox = INDICES_PER_BOX;
+        runCommands.clear();
+        forEachBoxRun(sortedBoxes, [&](uint32_t first, uint32_t count) {
+            runCommands.push_back({ count * perBox, 1, first * perBox, 0, 0 });
+        });
+        if (runCommands.empty()) return true;
+        const void* indirect;
+        if (!commands.write(runCommands.data(), runCommands.size(), indirect)) return false;
+        bind();
+        commands.bind();
+        commands.functions().multiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, indirect,
+                                                        static_cast<GLsizei>(runCommands.size()), 0);
+        return true;
+    }
+
+    size_t boxCount() const { return boxes; }
+
+    void release()
+    {
+        if (!VAO) return;
+        glDeleteVertexArrays(1, &VAO);
+        glDeleteBuffers(1, &VBO);
+        glDeleteBuffers(1, &EBO);
+        VAO = VBO = EBO = 0;
+    }
+
+private:
+    unsigned int VBO = 0, EBO = 0;
+    size_t boxes = 0;
+    std::vector<GLsizei> rangeCounts;
+    std::vector<const void*> rangeOffsets;
+    std::vector<DrawElementsIndirectCommand> runCommands;
+
+    void bind() const
+    {
+        glBindVertexArray(VAO);
+        // the wall shader's per-instance center/size are not arrays here, so pin
+        // them to identity through the generic attribute values
+        glVertexAttrib3f(1, 0.0f, 0.0f, 0.0f);
+        glVertexAttrib3f(2, 1.0f, 1.0f, 1.0f);
+    }
+};
+
+#endif
@@ -0,0 +1,235 @@
+#ifndef SWEEP_AND_PRUNE_H
+#define SWEEP_AND_PRUNE_H
+
+#include <glm/glm.hpp>
+
+#include "collision.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// Incremental sort-and-sweep broadphase. Every proxy has a min and max endpoint
+// on each tracked axis (X, optionally Z) in a persistent sorted list. After
+// proxies move, update() re-sorts with insertion sort; with frame-to-frame
+// coherence almost nothing swaps, so a tick is close to O(n). Each swap of a
+// min past a max is exactly where two intervals start or stop overlapping,
+// which keeps the overlapping-pair list current without a full sweep.
+//
+// Only pairs with at least one "tracked" proxy are kept (agents), so static
+// walls touching each other never fill the pair list.
+class SweepAndPrune {
+public:
+    explicit SweepAndPrune(bool trackZ = true) : axisCount(trackZ ? 2 : 1)
+    {
+    }
+
+    // proxies are handles; userData is free for the caller (e.g. an obstacle index)
+    uint32_t addProxy(const Box& bounds, bool tracked, uint32_t userData)
+    {
+        uint32_t h;
+        if (!freeHandles.empty()) {
+            h = freeHandles.back();
+            freeHandles.pop_back();
+        }
+        else {
+            h = static_cast<uint32_t>(proxies.size());
+            proxies.push_back({});
+        }
+        // start far beyond everything, then let insertion sort walk the endpoints in;
+        // the swaps on the way register every overlap the new proxy has
+        proxies[h] = { farBox(), tracked, userData };
+        for (int a = 0; a < axisCount; a++) {
+            endpoints[a].push_back({ proxies[h].bounds.min[axisIndex(a)], h, true });
+            endpoints[a].push_back({ proxies[h].bounds.max[axisIndex(a)], h, false });
+        }
+        proxies[h].bounds = bounds;
+        if (!bulkLoading) sortAxes();
+        return h;
+    }
+
+    void removeProxy(uint32_t h)
+    {
+        for (int a = 0; a < axisCount; a++) {
+            std::vector<Endpoint>& e = endpoints[a];
+            e.erase(std::remove_if(e.begin(), e.end(), [h](const Endpoint& p) { return p.proxy == h; }), e.end());
+        }
+        for (size_t i = 0; i < pairList.size();) {
+            if (pairList[i].first == h || pairList[i].second == h) removePairAt(i);
+            else i++;
+        }
+        freeHandles.push_back(h);
+    }
+
+    // new bounds take effect on the next update()
+    void setBounds(uint32_t h, const Box& bounds) { proxies[h].bounds = bounds; }
+    const Box& getBounds(uint32_t h) const { return proxies[h].bounds; }
+    uint32_t getUserData(uint32_t h) const { return proxies[h].userData; }
+    void setUserData(uint32_t h, uint32_t userData) { proxies[h].userData = userData; }
+    bool isTracked(uint32_t h) const { return proxies[h].tracked; }
+
+    // add many static proxies with one sort and one sweep instead of per-proxy insertion
+    void beginBulkLoad() { bulkLoading = true; }
+    void endBulkLoad()
+    {
+        bulkLoading = false;
+        for (int a = 0; a < axisCount; a++) {
+            refreshValues(a);
+            std::sort(endpoints[a].begin(), endpoints[a].end(), [](const Endpoint& x, const Endpoint& y) { return before(x, y); });
+        }
+        rebuildPairs();
+    }
+
+    // re-sort endpoints after setBounds calls, updating pairs on each crossing
+    void update() { sortAxes(); }
+
+    // current overlapping pairs (overlap on every tracked axis, inclusive)
+    const std::vector<std::pair<uint32_t, uint32_t>>& pairs() const { return pairList; }
+
+    size_t proxyCount() const { return proxies.size() - freeHandles.size(); }
+    size_t lastSwapCount() const { return swaps; }
+
+private:
+    struct Proxy {
+        Box bounds;
+        bool tracked;
+        uint32_t userData;
+    };
+    struct Endpoint {
+        float value;
+        uint32_t proxy;
+        bool isMin;
+    };
+
+    int axisCount;
+    std::vector<Proxy> proxies;
+    std::vector<uint32_t> freeHandles;
+    std::vector<Endpoint> endpoints[2]; // [0] = X, [1] = Z
+    std::vector<std::pair<uint32_t, uint32_t>> pairList;
+    std::unordered_map<uint64_t, uint32_t> pairIndex; // pair key -> index in pairList
+    bool bulkLoading = false;
+    size_t swaps = 0;
+
+    static Box farBox() { return { glm::vec3(3e38f), glm::vec3(3e38f) }; }
+    static int axisIndex(int a) { return a == 0 ? 0 : 2; }
+
+    // sort order: by value, and a min goes before a max at the same value so
+    // touching intervals count as overlapping (same as boxesOverlap)
+    static bool before(const Endpoint& x, const Endpoint& y)
+    {
+        return x.value < y.value || (x.value == y.value && x.isMin && !y.isMin);
+    }
+
+    static uint64_t pairKey(uint32_t a, uint32_t b)
+    {
+        if (a > b) std::swap(a, b);
+        return (static_cast<uint64_t>(a) << 32) | b;
+    }
+
+    bool wantsPair(uint32_t a, uint32_t b) const { return proxies[a].tracked || proxies[b].tracked; }
+
+    bool overlapOnTrackedAxes(uint32_t a, uint32_t b) const
+    {
+        const Box& x = proxies[a].bounds;
+        const Box& y = proxies[b].bounds;
+        for (int i = 0; i < axisCount; i++) {
+            int ax = axisIndex(i);
+            if (x.min[ax] > y.max[ax] || y.min[ax] > x.max[ax]) return false;
+        }
+        return true;
+    }
+
+    void addPair(uint32_t a, uint32_t b)
+    {
+        uint64_t key = pairKey(a, b);
+        if (pairIndex.count(key)) return;
+        pairIndex[key] = static_cast<uint32_t>(pairList.size());
+        pairList.push_back({ std::min(a, b), std::max(a, b) });
+    }
+
+    void removePair(uint32_t a, uint32_t b)
+    {
+        auto it = pairIndex.find(pairKey(a, b));
+        if (it != pairIndex.end()) removePairAt(it->second);
+    }
+
+    void removePairAt(size_t i)
+    {
+        pairIndex.erase(pairKey(pairList[i].first, pairList[i].second));
+        if (i + 1 != pairList.size()) {
+            pairList[i] = pairList.back();
+            pairIndex[pairKey(pairList[i].first, pairList[i].second)] = static_cast<uint32_t>(i);
+        }
+        pairList.pop_back();
+    }
+
+    void refreshValues(int a)
+    {
+        int ax = axisIndex(a);
+        for (Endpoint& e : endpoints[a]) {
+            const Box& b = proxies[e.proxy].bounds;
+            e.value = e.isMin ? b.min[ax] : b.max[ax];
+        }
+    }
+
+    void sortAxes()
+    {
+        swaps = 0;
+        for (int a = 0; a < axisCount; a++) {
+            refreshValues(a);
+            std::vector<Endpoint>& e = endpoints[a];
+            for (size_t i = 1; i < e.size(); i++) {
+                Endpoint key = e[i];
+                size_t j = i;
+                while (j > 0 && before(key, e[j - 1])) {
+                    const Endpoint& other = e[j - 1];
+                    if (wantsPair(key.proxy, other.proxy)) {
+                        // a min moving below a max: the intervals start to overlap on this axis
+                        if (key.isMin && !other.isMin) {
+                            if (overlapOnTrackedAxes(key.proxy, other.proxy)) addPair(key.proxy, other.proxy);
+                        }
+                        // a max moving below a min: they stop overlapping
+                        else if (!key.isMin && other.isMin) {
+                            removePair(key.proxy, other.proxy);
+                        }
+                    }
+                    e[j] = e[j - 1];
+                    j--;
+                    swaps++;
+                }
+                e[j] = key;
+            }
+        }
+    }
+
+    // full sweep along X (after a bulk load); static proxies only test against
+    // the active tracked ones, so static-vs-static overlaps cost nothing
+    void rebuildPairs()
+    {
+        pairList.clear();
+        pairIndex.clear();
+        std::vector<uint32_t> active, activeTracked;
+        for (const Endpoint& e : endpoints[0]) {
+            bool tracked = proxies[e.proxy].tracked;
+            std::vector<uint32_t>& list = tracked ? activeTracked : active;
+            if (e.isMin) {
+                for (uint32_t other : activeTracked)
+                    if (overlapOnTrackedAxes(e.proxy, other)) addPair(e.proxy, other);
+                if (tracked) {
+                    for (uint32_t other : active)
+                        if (overlapOnTrackedAxes(e.proxy, other)) addPair(e.proxy, other);
+                }
+                list.push_back(e.proxy);
+            }
+            else {
+                auto it = std::find(list.begin(), list.end(), e.proxy);
+                *it = list.back();
+                list.pop_back();
+            }
+        }
+    }
+};
+
+#endif
@@ -0,0 +1,108 @@
+#ifndef VERTEX_QUANTIZATION_H
+#define VERTEX_QUANTIZATION_H
+
+#include <glm/glm.hpp>
+
+#include <learnopengl/mesh.h>
+
+#include "collision.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+// 16-byte stand-in for Vertex (88 bytes):
+//   position   3 x unorm16 inside the model's bounds, dequantized in the vertex
+//              shader as position * positionScale + positionOffset
+//   normal     octahedral, 2 x snorm16 (attribute 1); 6.2.cubemaps.fs is unlit,
+//              so no shader here decodes it yet
+//   texCoords  2 x half float, read by GL as plain floats
+// Tangents, bitangents and bone data are dropped; nothing draws with them.
+struct CompactVertex {
+    uint16_t position[3];
+    uint16_t pad;
+    int16_t normal[2];
+    uint16_t texCoords[2];
+};
+static_assert(sizeof(CompactVertex) == 16, "CompactVertex must stay 16 bytes");
+
+// shader constants turning the unorm16 positions back into model space
+struct VertexDequantization {
+    glm::vec3 scale = glm::vec3(1.0f);
+    glm::vec3 offset = glm::vec3(0.0f);
+};
+
+// IEEE half, round to nearest even; overflow goes to infinity
+inline uint16_t floatToHalf(float f)
+{
+    uint32_t x;
+    std::memcpy(&x, &f, sizeof(x));
+    uint32_t sign = (x >> 16) & 0x8000u;
+    uint32_t exponent = (x >> 23) & 0xffu;
+    uint32_t mantissa = x & 0x7fffffu;
+    if (exponent == 0xffu) return static_cast<uint16_t>(sign | 0x7c00u | (mantissa ? 0x200u : 0u)); // inf / nan
+    int e = static_cast<int>(exponent) - 127 + 15;
+    if (e >= 31) return static_cast<uint16_t>(sign | 0x7c00u);
+    if (e <= 0) {
+        // subnormal half (or zero)
+        if (e < -10) return static_cast<uint16_t>(sign);
+        mantissa |= 0x800000u;
+        uint32_t shift = static_cast<uint32_t>(14 - e);
+        uint32_t half = mantissa >> shift;
+        uint32_t rest = mantissa & ((1u << shift) - 1u), middle = 1u << (shift - 1u);
+        if (rest > middle || (rest == middle && (half & 1u))) half++;
+        return static_cast<uint16_t>(sign | half);
+    }
+    uint32_t half = (static_cast<uint32_t>(e) << 10) | (mantissa >> 13);
+    uint32_t rest = mantissa & 0x1fffu;
+    if (rest > 0x1000u || (rest == 0x1000u && (half & 1u))) half++; // a carry rolls into the exponent, as it should
+    return static_cast<uint16_t>(sign | half);
+}
+
+// unit vector -> octahedral snorm16 pair
+inline void octEncode(const glm::vec3& n, int16_t out[2])
+{
+    float l1 = std::fabs(n.x) + std::fabs(n.y) + std::fabs(n.z);
+    float u = 0.0f, v = 0.0f;
+    if (l1 > 0.0f) {
+        u = n.x / l1;
+        v = n.y / l1;
+        if (n.z < 0.0f) {
+            // fold the lower hemisphere over the diagonals
+            float fu = (1.0f - std::fabs(v)) * (u >= 0.0f ? 1.0f : -1.0f);
+            float fv = (1.0f - std::fabs(u)) * (v >= 0.0f ? 1.0f : -1.0f);
+            u = fu;
+            v = fv;
+        }
+    }
+    out[0] = static_cast<int16_t>(std::lround(std::min(1.0f, std::max(-1.0f, u)) * 32767.0f));
+    out[1] = static_cast<int16_t>(std::lround(std::min(1.0f, std::max(-1.0f, v)) * 32767.0f));
+}
+
+// vertices -> out, positions relative to bounds; returns the dequantization for the shader
+inline VertexDequantization quantizeVertices(const Vertex* vertices, size_t count, const Box& bounds,
+                                             std::vector<CompactVertex>& out)
+{
+    VertexDequantization d;
+    glm::vec3 extent = glm::max(bounds.max - bounds.min, glm::vec3(0.0f));
+    d.offset = count ? bounds.min : glm::vec3(0.0f);
+    d.scale = extent;
+    out.resize(count);
+    for (size_t i = 0; i < count; i++) {
+        const Vertex& v = vertices[i];
+        CompactVertex& c = out[i];
+        for (int k = 0; k < 3; k++) {
+            float t = extent[k] > 0.0f ? (v.Position[k] - d.offset[k]) / extent[k] : 0.0f;
+            c.position[k] = static_cast<uint16_t>(std::lround(std::min(1.0f, std::max(0.0f, t)) * 65535.0f));
+        }
+        c.pad = 0;
+        octEncode(v.Normal, c.normal);
+        c.texCoords[0] = floatToHalf(v.TexCoords.x);
+        c.texCoords[1] = floatToHalf(v.TexCoords.y);
+    }
+    return d;
+}
+
+#endif
@@ -0,0 +1,114 @@
+#ifndef WORKER_POOL_H
+#define WORKER_POOL_H
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Small persistent thread pool. parallelFor splits [0, count) into chunks that
+// the workers and the calling thread pull from an atomic counter; it returns
+// once every chunk has run.
+class WorkerPool {
+public:
+    // threadCount 0 = one worker per hardware thread, minus the caller
+    explicit WorkerPool(unsigned int threadCount = 0)
+    {
+        if (threadCount == 0) {
+            unsigned int hw = std::thread::hardware_concurrency();
+            threadCount = hw > 1 ? hw - 1 : 0;
+        }
+        for (unsigned int i = 0; i < threadCount; i++)
+            threads.emplace_back([this] { workerLoop(); });
+    }
+
+    ~WorkerPool()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        wake.notify_all();
+        for (std::thread& t : threads) t.join();
+    }
+
+    WorkerPool(const WorkerPool&) = delete;
+    WorkerPool& operator=(const WorkerPool&) = delete;
+
+    unsigned int workerCount() const { return static_cast<unsigned int>(threads.size()); }
+
+    // run fn(begin, end) over [0, count) in chunks of about grain items
+    void parallelFor(size_t count, size_t grain, const std::function<void(size_t, size_t)>& fn)
+    {
+        if (count == 0) return;
+        grain = std::max<size_t>(1, grain);
+        if (threads.empty() || count <= grain) {
+            fn(0, count);
+            return;
+        }
+
+        std::unique_lock<std::mutex> lock(mutex);
+        job = &fn;
+        jobCount = count;
+        jobGrain = grain;
+        nextChunk.store(0);
+        busyWorkers = static_cast<unsigned int>(threads.size());
+        generation++;
+        lock.unlock();
+        wake.notify_all();
+
+        runChunks(fn, count, grain);
+
+        lock.lock();
+        done.wait(lock, [this] { return busyWorkers == 0; });
+        job = nullptr;
+    }
+
+private:
+    std::vector<std::thread> threads;
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable done;
+    bool stopping = false;
+    unsigned long long generation = 0;
+
+    const std::function<void(size_t, size_t)>* job = nullptr;
+    size_t jobCount = 0;
+    size_t jobGrain = 1;
+    std::atomic<size_t> nextChunk{ 0 };
+    unsigned int busyWorkers = 0;
+
+    void runChunks(const std::function<void(size_t, size_t)>& fn, size_t count, size_t grain)
+    {
+        while (true) {
+            size_t begin = nextChunk.fetch_add(grain);
+            if (begin >= count) break;
+            fn(begin, std::min(count, begin + grain));
+        }
+    }
+
+    void workerLoop()
+    {
+        unsigned long long seen = 0;
+        while (true) {
+            std::unique_lock<std::mutex> lock(mutex);
+            wake.wait(lock, [&] { return stopping || generation != seen; });
+            if (stopping) return;
+            seen = generation;
+            const std::function<void(size_t, size_t)>* fn = job;
+            size_t count = jobCount, grain = jobGrain;
+            lock.unlock();
+
+            runChunks(*fn, count, grain);
+
+            lock.lock();
+            if (--busyWorkers == 0) done.notify_one();
+        }
+    }
+};
+
+#endif